@@ -0,0 +1,295 @@
+#include <benchmark/benchmark.h>
+#include <brace/brace.h>
+#include <priv/brace/tokenizer.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// Benchmarks every stage of parsing on the usual corpora. Corpora are read
+// from BRACE_BENCH_DATA_DIR, or from the directory named by the
+// BRACE_BENCH_DATA environment variable, and those missing are skipped. The
+// NDJSON log is generated, so it is always there.
+//
+// Every benchmark reports throughput as bytes_per_second and the heap
+// allocations made per document as allocs_per_doc. Results are written as
+// JSON with --benchmark_format=json or --benchmark_out=<file>, for
+// comparing runs with the tools that come with Google Benchmark.
+
+namespace {
+
+// Allocations made through the global operator new, which the default
+// memory resource ends up in. Counted across all threads, parse_many()
+// allocates on its workers as well.
+std::atomic<size_t> g_allocations {0};
+
+struct Corpus {
+    std::string name;
+    std::string json;
+};
+
+std::vector<Corpus>& corpora() {
+    static std::vector<Corpus> corpora;
+    return corpora;
+}
+
+bool read_file(const std::string& path, std::string& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    out = contents.str();
+    return true;
+}
+
+// Log records of a made-up service, the same on every run
+std::string generate_log(size_t records) {
+    static const char* levels[] = {"debug", "info", "info", "warn", "error"};
+    static const char* paths[] = {
+        "/api/users",
+        "/api/orders",
+        "/healthz",
+        "/api/search",
+    };
+    std::string log;
+    uint32_t seed = 12345;
+    auto next = [&] {
+        seed = seed * 1103515245u + 12345u;
+        return seed >> 8;
+    };
+    for (size_t i = 0; i < records; i++) {
+        log += R"({"ts":)" + std::to_string(1700000000000 + i * 17);
+        log += R"(,"level":")" + std::string(levels[next() % 5]);
+        log += R"(","path":")" + std::string(paths[next() % 4]);
+        log += R"(","status":)" + std::to_string(200 + next() % 4 * 100);
+        log += R"(,"latency_ms":)" + std::to_string(next() % 5000 / 10.0);
+        log += R"(,"user":{"id":)" + std::to_string(next() % 100000);
+        log += R"x(,"agent":"Mozilla/5.0 (X11; Linux x86_64)"},"tags":["svc",")x";
+        log += std::to_string(next() % 16) + "\"]}\n";
+    }
+    return log;
+}
+
+// `documents` is how many documents the input holds, records for NDJSON
+void report(
+    benchmark::State& state,
+    size_t bytes,
+    size_t allocations,
+    size_t documents = 1
+) {
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+    state.counters["allocs_per_doc"] = benchmark::Counter(
+        static_cast<double>(allocations)
+        / static_cast<double>(state.iterations() * documents)
+    );
+}
+
+void BM_tokenize(benchmark::State& state, const Corpus* corpus) {
+    priv::brace::Tokenizer tokenizer;
+    size_t allocations = 0;
+    for (auto _ : state) {
+        size_t before = g_allocations;
+        tokenizer.reset(corpus->json);
+        while (true) {
+            auto token = tokenizer.next_token(corpus->json);
+            if (token.is_err()) {
+                state.SkipWithError("Malformed corpus");
+                return;
+            }
+            if (token.unwrap().type == priv::brace::TokenType::Eof) {
+                break;
+            }
+            benchmark::DoNotOptimize(token);
+        }
+        allocations += g_allocations - before;
+    }
+    report(state, corpus->json.size(), allocations);
+}
+
+// Builds a DOM, timing the parse alone. Destroying it is timed separately.
+void BM_parse(benchmark::State& state, const Corpus* corpus) {
+    brace::Parser parser;
+    size_t allocations = 0;
+    for (auto _ : state) {
+        size_t before = g_allocations;
+        auto start = std::chrono::steady_clock::now();
+        auto value = parser.parse(corpus->json);
+        auto end = std::chrono::steady_clock::now();
+        allocations += g_allocations - before;
+        if (value.is_err()) {
+            state.SkipWithError("Malformed corpus");
+            return;
+        }
+        benchmark::DoNotOptimize(value);
+        state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+    }
+    report(state, corpus->json.size(), allocations);
+}
+
+void BM_destroy(benchmark::State& state, const Corpus* corpus) {
+    brace::Parser parser;
+    for (auto _ : state) {
+        auto value = parser.parse(corpus->json);
+        if (value.is_err()) {
+            state.SkipWithError("Malformed corpus");
+            return;
+        }
+        auto start = std::chrono::steady_clock::now();
+        { auto destroyed = std::move(value).unwrap(); }
+        auto end = std::chrono::steady_clock::now();
+        state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+    }
+    state.SetBytesProcessed(
+        static_cast<int64_t>(state.iterations() * corpus->json.size())
+    );
+}
+
+// Parses into a reused arena, which is the whole cost of a document
+void BM_parse_document(benchmark::State& state, const Corpus* corpus) {
+    brace::Parser parser;
+    brace::Document document;
+    size_t allocations = 0;
+    for (auto _ : state) {
+        size_t before = g_allocations;
+        auto parsed = parser.parse_document(corpus->json, document);
+        allocations += g_allocations - before;
+        if (parsed.is_err()) {
+            state.SkipWithError("Malformed corpus");
+            return;
+        }
+        benchmark::DoNotOptimize(document.root());
+    }
+    report(state, corpus->json.size(), allocations);
+}
+
+void BM_parse_many(benchmark::State& state, const Corpus* corpus) {
+    brace::Parser parser;
+    size_t allocations = 0;
+    size_t records = 0;
+    for (auto _ : state) {
+        bool valid = true;
+        size_t before = g_allocations;
+        records = parser.parse_many(corpus->json, [&](size_t, auto&& record) {
+            valid = valid && record.is_ok();
+            return true;
+        });
+        allocations += g_allocations - before;
+        if (!valid) {
+            state.SkipWithError("Malformed corpus");
+            return;
+        }
+    }
+    report(state, corpus->json.size(), allocations, records);
+}
+
+void register_corpus(const Corpus& corpus, bool records) {
+    const std::string& name = corpus.name;
+    if (records) {
+        benchmark::RegisterBenchmark(
+            ("parse_many/" + name).c_str(),
+            BM_parse_many,
+            &corpus
+        )->Unit(benchmark::kMillisecond);
+        return;
+    }
+    benchmark::RegisterBenchmark(("tokenize/" + name).c_str(), BM_tokenize, &corpus)
+        ->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark(("parse/" + name).c_str(), BM_parse, &corpus)
+        ->UseManualTime()
+        ->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark(("destroy/" + name).c_str(), BM_destroy, &corpus)
+        ->UseManualTime()
+        ->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark(
+        ("parse_document/" + name).c_str(),
+        BM_parse_document,
+        &corpus
+    )->Unit(benchmark::kMillisecond);
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+// std::pmr::new_delete_resource() allocates through the aligned forms
+void* operator new(size_t size, std::align_val_t align) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t alignment = static_cast<size_t>(align);
+#ifdef _WIN32
+    void* p = _aligned_malloc(size ? size : 1, alignment);
+#else
+    // The size must be a multiple of the alignment
+    void* p = std::aligned_alloc(alignment, (size / alignment + 1) * alignment);
+#endif
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void operator delete(void* p, size_t, std::align_val_t align) noexcept {
+    operator delete(p, align);
+}
+
+int main(int argc, char** argv) {
+    const char* data_dir = std::getenv("BRACE_BENCH_DATA");
+    std::string dir = data_dir ? data_dir : BRACE_BENCH_DATA_DIR;
+
+    // Registered benchmarks keep pointers to their corpus
+    corpora().reserve(4);
+    for (const char* name : {"twitter.json", "canada.json", "citm_catalog.json"}) {
+        Corpus corpus {name, {}};
+        if (read_file(dir + "/" + name, corpus.json) && !corpus.json.empty()) {
+            corpora().push_back(std::move(corpus));
+        } else {
+            std::fprintf(stderr, "Skipping %s, not found in %s\n", name, dir.c_str());
+        }
+    }
+    corpora().push_back(Corpus {"logs.ndjson", generate_log(20000)});
+
+    for (const Corpus& corpus : corpora()) {
+        register_corpus(corpus, corpus.name == "logs.ndjson");
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
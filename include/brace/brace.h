@@ -1,88 +1,496 @@
 #ifndef __BRACE_JSON_H__
 #define __BRACE_JSON_H__
 
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <optional>
 #include <sstream>
 #include <string>
-#include <unordered_map>
-#include <variant>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "../priv/brace/tokenizer.h"
+#include "error.h"
 #include "result.h"
 
+namespace priv::brace {
+
+template<typename Handler>
+class SaxDriver;
+
+class ValueReader;
+class KeyTable;
+class DomBuilder;
+class StringTable;
+
+// A container SaxDriver is in the middle of
+struct SaxFrame {
+    size_t count;  // Members or elements so far
+    bool is_object;
+};
+
+}  // namespace priv::brace
+
 namespace brace {
 
 class JsonValue;
+class LazyDocument;
+class Path;
 
 struct JsonNullValue {};
 
-using JsonObject = std::unordered_map<std::string, JsonValue>;
-using JsonArray = std::vector<JsonValue>;
+using JsonString = std::pmr::string;
+using JsonArray = std::pmr::vector<JsonValue>;
+
+/**
+ * @brief The key of a JsonObject member.
+ *
+ * Keys of up to `max_inline_size` bytes are stored inline. Longer ones are
+ * kept in a block along with their hash, which either belongs to the key
+ * or, for keys interned by a Document, is shared by every equal key of the
+ * document (see Parser::set_intern_keys()). Keys sharing a block compare
+ * equal without looking at their characters.
+ *
+ * Copies never share: they get an inline key or a block of their own from
+ * the default resource, just like JsonValue copies.
+ */
+class JsonKey {
+  public:
+    static constexpr size_t max_inline_size = 15;
+
+    JsonKey() = default;
+
+    explicit JsonKey(
+        std::string_view key,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    ) {
+        init(key, resource);
+    }
+
+    JsonKey(const JsonKey& other) {
+        init(other.view(), std::pmr::get_default_resource());
+    }
+
+    JsonKey(JsonKey&& other) noexcept {
+        take(other);
+    }
+
+    JsonKey& operator=(const JsonKey& other) {
+        if (this != &other) {
+            JsonKey copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    JsonKey& operator=(JsonKey&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            take(other);
+        }
+        return *this;
+    }
+
+    ~JsonKey() {
+        destroy();
+    }
+
+    std::string_view view() const {
+        if (m_size == rep_key) {
+            const Rep* rep = load_rep();
+            return std::string_view(rep->chars(), rep->size);
+        }
+        return std::string_view(m_data, m_size);
+    }
+
+    operator std::string_view() const {
+        return view();
+    }
+
+    const char* data() const {
+        return view().data();
+    }
+
+    size_t size() const {
+        return view().size();
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    /**
+     * @brief Retrieves `std::hash<std::string_view>` of the key, which is
+     *        only computed once for keys not stored inline.
+     */
+    size_t hash() const {
+        if (m_size == rep_key) {
+            return load_rep()->hash;
+        }
+        return std::hash<std::string_view>()(view());
+    }
+
+    /**
+     * @brief Checks if the key shares its block with the equal keys of a
+     *        document.
+     */
+    bool is_interned() const {
+        return m_size == rep_key && load_rep()->resource == nullptr;
+    }
+
+    friend bool operator==(const JsonKey& a, const JsonKey& b) {
+        if (a.m_size == rep_key && b.m_size == rep_key
+            && a.load_rep() == b.load_rep()) {
+            return true;
+        }
+        return a.view() == b.view();
+    }
+
+    friend bool operator==(const JsonKey& a, std::string_view b) {
+        return a.view() == b;
+    }
+
+    friend bool operator!=(const JsonKey& a, const JsonKey& b) {
+        return !(a == b);
+    }
+
+    friend bool operator!=(const JsonKey& a, std::string_view b) {
+        return !(a == b);
+    }
+
+  private:
+    friend class ::priv::brace::KeyTable;
+
+    // Keys too long to be stored inline, followed by their characters
+    struct Rep {
+        // Null for interned keys, which are freed along with their document
+        std::pmr::memory_resource* resource;
+        size_t hash;
+        size_t size;
+
+        const char* chars() const {
+            return reinterpret_cast<const char*>(this + 1);
+        }
+
+        char* chars() {
+            return reinterpret_cast<char*>(this + 1);
+        }
+    };
+
+    static constexpr uint8_t rep_key = UINT8_MAX;
+
+    // Holds the inline key or the pointer to its Rep
+    alignas(8) char m_data[max_inline_size] {};
+    // Length of an inline key, rep_key for one stored behind a pointer
+    uint8_t m_size {0};
+
+    // Refers to a Rep owned by someone else
+    explicit JsonKey(const Rep* rep) : m_size(rep_key) {
+        std::memcpy(m_data, &rep, sizeof(rep));
+    }
+
+    const Rep* load_rep() const {
+        const Rep* rep;
+        std::memcpy(&rep, m_data, sizeof(rep));
+        return rep;
+    }
+
+    void init(std::string_view key, std::pmr::memory_resource* resource);
+    void destroy() noexcept;
+
+    void take(JsonKey& other) noexcept {
+        std::memcpy(m_data, other.m_data, sizeof(m_data));
+        m_size = std::exchange(other.m_size, 0);
+    }
+};
+
+/**
+ * @brief An insertion-ordered JSON object stored as a flat array of members.
+ *
+ * Small objects, which most are, are searched linearly: that beats hashing
+ * for a handful of keys and keeps iteration cache friendly. Once an object
+ * grows past `index_threshold` members, an open-addressing hash index over
+ * the members is built and then kept up to date on every insertion.
+ *
+ * Member keys must not be modified through iterators. Like the other
+ * containers, members allocate through a std::pmr allocator.
+ */
+class JsonObject {
+  public:
+    using value_type = std::pair<JsonKey, JsonValue>;
+    using allocator_type = std::pmr::polymorphic_allocator<value_type>;
+    using iterator = std::pmr::vector<value_type>::iterator;
+    using const_iterator = std::pmr::vector<value_type>::const_iterator;
+
+    /**
+     * @brief Objects with more members than this are looked up through a
+     *        hash index.
+     */
+    static constexpr size_t index_threshold = 16;
+
+    JsonObject() = default;
+    explicit JsonObject(const allocator_type& allocator);
+
+    allocator_type get_allocator() const;
+
+    size_t size() const;
+    bool empty() const;
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /**
+     * @brief Finds the member with the given key.
+     *
+     * @return An iterator to the member, end() if there is none
+     */
+    iterator find(std::string_view key);
+    const_iterator find(std::string_view key) const;
+
+    /**
+     * @brief Finds the member with the given key, hashed beforehand.
+     *
+     * Saves hashing the key again on every lookup in large objects.
+     *
+     * @param hash `std::hash<std::string_view>` of the key
+     * @return An iterator to the member, end() if there is none
+     */
+    const_iterator find(std::string_view key, size_t hash) const;
+
+    bool contains(std::string_view key) const;
+
+    /**
+     * @brief Retrieves the value of the member with the given key.
+     *
+     * @throws std::out_of_range if there is no such member
+     */
+    JsonValue& at(std::string_view key);
+    const JsonValue& at(std::string_view key) const;
+
+    /**
+     * @brief Retrieves the value of a member, adding a null one if missing.
+     */
+    JsonValue& operator[](std::string_view key);
+
+    /**
+     * @brief Adds a member, or replaces the value of the existing member
+     *        with the same key in its original position.
+     *
+     * @return The member and whether it was newly added
+     */
+    std::pair<iterator, bool> insert_or_assign(JsonKey key, JsonValue value);
+
+    std::pair<iterator, bool>
+    insert_or_assign(const JsonString& key, JsonValue value);
+
+    /**
+     * @brief Removes the member with the given key, if any.
+     *
+     * @return The number of members removed
+     */
+    size_t erase(std::string_view key);
+
+    void reserve(size_t capacity);
+    void clear();
+
+  private:
+    std::pmr::vector<value_type> m_members;
+    // Empty while the object is small. Otherwise a power-of-two sized table
+    // of member positions plus one, zero marking a free slot.
+    std::pmr::vector<uint32_t> m_index;
+
+    size_t find_member(std::string_view key) const;
+    size_t find_member(std::string_view key, size_t hash) const;
+    size_t find_linear(std::string_view key) const;
+    size_t find_indexed(std::string_view key, size_t hash) const;
+    void index_member(size_t position);
+    void rebuild_index();
+};
+
+/**
+ * @brief The kinds of value a JsonValue can hold.
+ */
+enum class JsonType : uint8_t {
+    Null,
+    Bool,
+    Int64,
+    Uint64,
+    Double,
+    String,
+    Object,
+    Array,
+};
 
 /**
  * @brief Represents a flexible JSON value that can hold different types of data.
  *
  * Supported JSON value types:
- * - Null (JsonNullValue)
+ * - Null
  * - Boolean
- * - Number (double)
+ * - Number (int64_t, uint64_t or double)
  * - String
- * - Object (unordered map of key-value pairs)
+ * - Object (insertion-ordered key-value pairs)
  * - Array (vector of JsonValues)
+ *
+ * Integers are stored exactly, as int64_t when they fit and as uint64_t
+ * otherwise. Numbers with a fraction or an exponent are stored as double.
+ *
+ * A JsonValue is 16 bytes: a type tag and an inline payload. Scalars and
+ * strings of up to 14 bytes are stored in place, longer strings, objects and
+ * arrays behind a pointer. Those allocate through std::pmr memory resources.
+ * Moving a JsonValue keeps its memory resource, copying one allocates the
+ * copy from the default resource.
+ *
+ * Values can also be shared (see share() and Parser::set_shared_values()).
+ * Their strings, objects and arrays are then kept in reference counted
+ * blocks, and copying one of them, or any value nested in it, only counts
+ * another reference. Since values can not be modified once built, copies
+ * can be handed to other threads and read there. Changed versions are made
+ * with with(), which copies the containers on the way to the change and
+ * shares everything else.
  */
 class JsonValue {
   public:
-    /**
-    * @brief Internal type definition for storing different JSON value types.
-    */
-    using Value = std::variant<
-        bool,
-        double,
-        std::string,
-        JsonObject,
-        JsonArray,
-        JsonNullValue>;
-
     /**
      * @brief Default constructor. Creates a null JSON value.
      */
-    JsonValue() : m_value(JsonNullValue {}) {}
+    JsonValue() = default;
 
     /**
      * @brief Constructs a JSON value from a boolean.
      *
      * @param b The boolean value to store
      */
-    JsonValue(bool b) : m_value(b) {}
+    JsonValue(bool b) : m_type(JsonType::Bool) {
+        store(b);
+    }
 
     /**
      * @brief Constructs a JSON value from a numeric value.
      *
      * @param d The numeric value to store (as a double)
      */
-    JsonValue(double d) : m_value(d) {}
+    JsonValue(double d) : m_type(JsonType::Double) {
+        store(d);
+    }
+
+    /**
+     * @brief Constructs a JSON value from an integer, stored exactly.
+     *
+     * @param n The integer value to store
+     */
+    template<
+        typename T,
+        std::enable_if_t<
+            std::is_integral_v<T> && !std::is_same_v<T, bool>,
+            int> = 0>
+    JsonValue(T n) {
+        // Integers are kept as int64_t whenever they fit, so each number has
+        // a single representation
+        if (std::is_signed_v<T> || static_cast<uint64_t>(n) <= INT64_MAX) {
+            m_type = JsonType::Int64;
+            store(static_cast<int64_t>(n));
+        } else {
+            m_type = JsonType::Uint64;
+            store(static_cast<uint64_t>(n));
+        }
+    }
 
     /**
      * @brief Constructs a JSON value from a string.
      *
      * @param s The string to store
      */
-    JsonValue(const std::string& s) : m_value(s) {}
+    JsonValue(const std::string& s) :
+        JsonValue(std::string_view(s), std::pmr::get_default_resource()) {}
+
+    /**
+     * @brief Constructs a JSON value from a string, allocating from `resource`.
+     *
+     * @param s The string to store
+     * @param resource The resource to allocate a long string from
+     */
+    JsonValue(std::string_view s, std::pmr::memory_resource* resource);
+
+    /**
+     * @brief Constructs a JSON value from a string, keeping its allocator.
+     *
+     * @param s The string to store
+     */
+    JsonValue(JsonString&& s) :
+        JsonValue(std::string_view(s), s.get_allocator().resource()) {}
 
     /**
      * @brief Constructs a JSON value from an object (map of key-value pairs).
      *
      * @param obj The JSON object to store
      */
-    JsonValue(const JsonObject& obj) : m_value(obj) {}
+    JsonValue(const JsonObject& obj);
+
+    /**
+     * @brief Constructs a JSON value by taking over an object and its allocator.
+     *
+     * @param obj The JSON object to store
+     */
+    JsonValue(JsonObject&& obj);
 
     /**
      * @brief Constructs a JSON value from an array.
      *
      * @param arr The JSON array to store
      */
-    JsonValue(const JsonArray& arr) : m_value(arr) {}
+    JsonValue(const JsonArray& arr);
+
+    /**
+     * @brief Constructs a JSON value by taking over an array and its allocator.
+     *
+     * @param arr The JSON array to store
+     */
+    JsonValue(JsonArray&& arr);
+
+    JsonValue(const JsonValue& other);
+
+    JsonValue(JsonValue&& other) noexcept {
+        take(other);
+    }
+
+    JsonValue& operator=(const JsonValue& other) {
+        if (this != &other) {
+            JsonValue copy(other);
+            release();
+            take(copy);
+        }
+        return *this;
+    }
+
+    JsonValue& operator=(JsonValue&& other) noexcept {
+        if (this != &other) {
+            release();
+            take(other);
+        }
+        return *this;
+    }
+
+    ~JsonValue() {
+        release();
+    }
+
+    /**
+     * @brief Retrieves the kind of value stored.
+     */
+    inline JsonType type() const {
+        return m_type;
+    }
 
     /**
      * @brief Checks if the current value is null.
@@ -90,7 +498,7 @@ class JsonValue {
      * @return true if the value is null, false otherwise
      */
     inline bool is_null() const {
-        return std::holds_alternative<JsonNullValue>(m_value);
+        return m_type == JsonType::Null;
     }
 
     /**
@@ -99,7 +507,7 @@ class JsonValue {
      * @return true if the value is a boolean, false otherwise
      */
     inline bool is_bool() const {
-        return std::holds_alternative<bool>(m_value);
+        return m_type == JsonType::Bool;
     }
 
     /**
@@ -108,7 +516,17 @@ class JsonValue {
      * @return true if the value is a numeric value, false otherwise
      */
     inline bool is_number() const {
-        return std::holds_alternative<double>(m_value);
+        return m_type == JsonType::Int64 || m_type == JsonType::Uint64
+            || m_type == JsonType::Double;
+    }
+
+    /**
+     * @brief Checks if the current value is a number stored as an integer.
+     *
+     * @return true if the value is an int64_t or a uint64_t, false otherwise
+     */
+    inline bool is_integer() const {
+        return m_type == JsonType::Int64 || m_type == JsonType::Uint64;
     }
 
     /**
@@ -117,7 +535,7 @@ class JsonValue {
      * @return true if the value is a string, false otherwise
      */
     inline bool is_string() const {
-        return std::holds_alternative<std::string>(m_value);
+        return m_type == JsonType::String;
     }
 
     /**
@@ -126,7 +544,7 @@ class JsonValue {
      * @return true if the value is an object, false otherwise
      */
     inline bool is_object() const {
-        return std::holds_alternative<JsonObject>(m_value);
+        return m_type == JsonType::Object;
     }
 
     /**
@@ -135,16 +553,7 @@ class JsonValue {
      * @return true if the value is an array, false otherwise
      */
     inline bool is_array() const {
-        return std::holds_alternative<JsonArray>(m_value);
-    }
-
-    /**
-     * @brief Retrieves the internal variant value.
-     *
-     * @return const Reference to the underlying std::variant value
-     */
-    inline const Value& value() const {
-        return m_value;
+        return m_type == JsonType::Array;
     }
 
     /**
@@ -156,7 +565,7 @@ class JsonValue {
      */
     inline operator std::string() const {
         assert(is_string() && "JsonValue is not a string");
-        return std::get<std::string>(m_value);
+        return std::string(string_view());
     }
 
     /**
@@ -167,8 +576,7 @@ class JsonValue {
      * @return The stored value converted to an int
      */
     inline operator int() const {
-        assert(is_number() && "JsonValue is not a number");
-        return static_cast<int>(std::get<double>(m_value));
+        return number_as<int>();
     }
 
     /**
@@ -179,8 +587,40 @@ class JsonValue {
      * @return The stored value converted to a double
      */
     inline operator double() const {
-        assert(is_number() && "JsonValue is not a number");
-        return std::get<double>(m_value);
+        return number_as<double>();
+    }
+
+    /**
+     * @brief Retrieves the number as a signed 64-bit integer.
+     *
+     * @pre The JsonValue must be a numeric type
+     * @throws Asserts in debug build the value must be a number.
+     * @return The stored value, exact if it is an integer in range
+     */
+    inline int64_t to_int64() const {
+        return number_as<int64_t>();
+    }
+
+    /**
+     * @brief Retrieves the number as an unsigned 64-bit integer.
+     *
+     * @pre The JsonValue must be a numeric type
+     * @throws Asserts in debug build the value must be a number.
+     * @return The stored value, exact if it is an integer in range
+     */
+    inline uint64_t to_uint64() const {
+        return number_as<uint64_t>();
+    }
+
+    /**
+     * @brief Retrieves the number as a double.
+     *
+     * @pre The JsonValue must be a numeric type
+     * @throws Asserts in debug build the value must be a number.
+     * @return The stored value converted to a double
+     */
+    inline double to_double() const {
+        return number_as<double>();
     }
 
     /**
@@ -191,8 +631,7 @@ class JsonValue {
      * @return The stored value converted to a float
      */
     inline operator float() const {
-        assert(is_number() && "JsonValue is not a number");
-        return static_cast<float>(std::get<double>(m_value));
+        return number_as<float>();
     }
 
     /**
@@ -203,8 +642,7 @@ class JsonValue {
      * @return The stored value converted to an size_t
      */
     inline operator size_t() const {
-        assert(is_number() && "JsonValue is not a number");
-        return static_cast<size_t>(std::get<double>(m_value));
+        return number_as<size_t>();
     }
 
     /**
@@ -216,7 +654,19 @@ class JsonValue {
      */
     inline operator bool() const {
         assert(is_bool() && "JsonValue is not a bool");
-        return std::get<bool>(m_value);
+        return load<bool>();
+    }
+
+    /**
+     * @brief Retrieves the contents of a string without copying them.
+     *
+     * @pre The JsonValue must be a string type
+     * @throws Asserts in debug build the value must be a string.
+     * @return View of the stored string, valid while the value lives
+     */
+    inline std::string_view to_string_view() const {
+        assert(is_string() && "JsonValue is not a string");
+        return string_view();
     }
 
     /**
@@ -228,9 +678,31 @@ class JsonValue {
      */
     inline const JsonArray& to_array() const {
         assert(is_array() && "JsonValue is not an array");
-        return std::get<JsonArray>(m_value);
+        return *load<JsonArray*>();
     }
 
+    /**
+     * @brief Retrieves the object value of the JsonValue.
+     *
+     * @pre The JsonValue must be an object type
+     * @throws Asserts in debug build the value must be an object.
+     * @return Reference to the stored JsonObject
+     */
+    inline const JsonObject& to_object() const {
+        assert(is_object() && "JsonValue is not an object");
+        return *load<JsonObject*>();
+    }
+
+    /**
+     * @brief Serializes the JsonValue to JSON text.
+     *
+     * A shorthand for writing the value with a Writer, see brace/writer.h.
+     *
+     * @param indent Spaces per nesting level, 0 for compact output
+     * @return The JSON text
+     */
+    std::string to_string(size_t indent = 0) const;
+
     /**
      * @brief Compares the JsonValue with a string.
      *
@@ -238,10 +710,7 @@ class JsonValue {
      * @return true if the JsonValue is a string and matches the provided string, false otherwise
      */
     inline bool operator==(const std::string& other) const {
-        if (std::holds_alternative<std::string>(m_value)) {
-            return std::get<std::string>(m_value) == other;
-        }
-        return false;
+        return is_string() && string_view() == other;
     }
 
     /**
@@ -251,7 +720,7 @@ class JsonValue {
      * @return true if the JsonValue is a string and matches the provided C-string, false otherwise
      */
     inline bool operator==(const char* other) const {
-        return *this == std::string(other);
+        return is_string() && string_view() == other;
     }
 
     /**
@@ -261,21 +730,39 @@ class JsonValue {
      * @return true if the JsonValue is a number and matches the provided double, false otherwise
      */
     inline bool operator==(double other) const {
-        if (std::holds_alternative<double>(m_value)) {
-            return std::get<double>(m_value) == other;
-        }
-        return false;
+        return is_number() && number_as<double>() == other;
     }
 
     /**
      * @brief Compares the JsonValue with an integer.
      *
+     * Integers are compared exactly, without going through floating point.
+     *
      * @param other Integer value to compare against
      * @return true if the JsonValue is a number and matches the provided integer, false otherwise
      */
-    inline bool operator==(int other) const {
-        if (std::holds_alternative<double>(m_value)) {
-            return std::get<double>(m_value) == other;
+    template<
+        typename T,
+        std::enable_if_t<
+            std::is_integral_v<T> && !std::is_same_v<T, bool>,
+            int> = 0>
+    inline bool operator==(T other) const {
+        if (m_type == JsonType::Int64) {
+            int64_t n = load<int64_t>();
+            if constexpr (std::is_signed_v<T>) {
+                return n == static_cast<int64_t>(other);
+            } else {
+                return n >= 0 && static_cast<uint64_t>(n) == other;
+            }
+        } else if (m_type == JsonType::Uint64) {
+            uint64_t n = load<uint64_t>();
+            if constexpr (std::is_signed_v<T>) {
+                return other >= 0 && n == static_cast<uint64_t>(other);
+            } else {
+                return n == other;
+            }
+        } else if (m_type == JsonType::Double) {
+            return load<double>() == static_cast<double>(other);
         }
         return false;
     }
@@ -289,18 +776,69 @@ class JsonValue {
      * @return Reference to the JsonValue associated with the key
      */
     inline const JsonValue& operator[](const std::string& key) const {
-        return operator[](key.c_str());
+        assert(is_object() && "JsonValue is not an object");
+        return load<JsonObject*>()->at(key);
     }
 
-    inline bool contains(const std::string& key) const {
+    /**
+     * @brief Checks if an object has a member with the given key.
+     *
+     * @param key The key to look up
+     * @return true if the JsonValue is an object with such a member, false otherwise
+     */
+    inline bool contains(std::string_view key) const {
         if (is_object()) {
-            auto object = std::get<JsonObject>(m_value);
-            auto it = object.find(key);
-            return it != object.end();
+            return load<JsonObject*>()->contains(key);
         }
         return false;
     }
 
+    /**
+     * @brief Looks up the value a compiled JSON Pointer refers to.
+     *
+     * @param path The path to follow from this value
+     * @return The value, or null if the path leads nowhere
+     */
+    const JsonValue* find(const Path& path) const;
+
+    /**
+     * @brief Makes a copy with the value at a path replaced.
+     *
+     * Only the arrays and objects the path goes through are copied, with
+     * the same sharing as the originals, everything else is shared with
+     * this value if it is shared and copied otherwise. A member missing
+     * from the last object is added, as is an element past the end of the
+     * last array with the key "-" or an index of its size.
+     *
+     * @param path Where to put the value, see brace/path.h
+     * @param value The value to put there
+     * @return The changed copy, or nothing if the path leads nowhere
+     */
+    std::optional<JsonValue> with(const Path& path, JsonValue value) const;
+
+    /**
+     * @brief Makes a shared copy of the value.
+     *
+     * Shared values are copied by counting a reference, and so are the
+     * values nested in them. A value that is already shared is copied that
+     * way, others are copied once more into blocks of the default
+     * resource. Documents can not share their values, which go away with
+     * the document's arena.
+     *
+     * @return The shared copy, which is the same value
+     */
+    JsonValue share() const;
+
+    /**
+     * @brief Checks if copying the value only counts a reference.
+     *
+     * True for strings, arrays and objects held in shared blocks. Scalars
+     * and short strings, which are copied in place, are never shared.
+     */
+    inline bool is_shared() const {
+        return m_type >= JsonType::String && m_string_size == shared_rep;
+    }
+
     /**
      * @brief Accesses an object's value by C-style string key.
      *
@@ -311,7 +849,7 @@ class JsonValue {
      */
     inline const JsonValue& operator[](const char* key) const {
         assert(is_object() && "JsonValue is not an object");
-        return std::get<JsonObject>(m_value).at(key);
+        return load<JsonObject*>()->at(key);
     }
 
     /**
@@ -324,36 +862,381 @@ class JsonValue {
      */
     inline const JsonValue& operator[](size_t index) const {
         assert(is_array() && "JsonValue is not an array");
-        return std::get<JsonArray>(m_value).at(index);
+        return load<JsonArray*>()->at(index);
     }
 
   private:
-    Value m_value;
+    friend class Parser;
+    friend class ::priv::brace::DomBuilder;
+    friend class ::priv::brace::StringTable;
+
+    // Strings too long to be stored inline, followed by their characters
+    struct StringRep {
+        std::pmr::memory_resource* resource;
+        size_t size;
+
+        char* chars() {
+            return reinterpret_cast<char*>(this + 1);
+        }
+    };
+
+    // Goes before the StringRep, JsonObject or JsonArray of shared values,
+    // which is freed along with the last value referring to it
+    struct alignas(std::max_align_t) SharedHeader {
+        std::atomic<size_t> refs;
+    };
+
+    static constexpr size_t max_inline_size = 14;
+    static constexpr uint8_t heap_string = UINT8_MAX;
+    static constexpr uint8_t shared_rep = UINT8_MAX - 1;
+    static constexpr uint8_t interned_string = UINT8_MAX - 2;
+
+    // Holds the scalar, the inline string or the pointer to the heap
+    // representation, depending on m_type
+    alignas(8) char m_data[max_inline_size] {};
+    // Length of an inline string, heap_string for one stored behind a
+    // pointer. shared_rep for strings, objects and arrays in a shared block,
+    // interned_string for strings a document's string table owns.
+    uint8_t m_string_size {0};
+    JsonType m_type {JsonType::Null};
+
+    template<typename T>
+    void store(T value) {
+        std::memcpy(m_data, &value, sizeof(T));
+    }
+
+    template<typename T>
+    T load() const {
+        T value;
+        std::memcpy(&value, m_data, sizeof(T));
+        return value;
+    }
+
+    // Steals the payload of `other` and leaves it null
+    void take(JsonValue& other) noexcept {
+        std::memcpy(m_data, other.m_data, sizeof(m_data));
+        m_string_size = other.m_string_size;
+        m_type = std::exchange(other.m_type, JsonType::Null);
+    }
+
+    void release() noexcept {
+        if (m_type >= JsonType::String) {
+            destroy();
+        }
+    }
+
+    // Shared values, allocated from `resource`
+    static JsonValue
+    shared_string(std::string_view s, std::pmr::memory_resource* resource);
+    static JsonValue shared_object(JsonObject&& obj);
+    static JsonValue shared_array(JsonArray&& arr);
+
+    // A shared block for a representation of `size` bytes, with one
+    // reference. Returns where the representation goes.
+    static void* allocate_shared(std::pmr::memory_resource* resource, size_t size);
+
+    SharedHeader* shared_header() const {
+        return reinterpret_cast<SharedHeader*>(load<char*>()) - 1;
+    }
+
+    void init_string(std::string_view s, std::pmr::memory_resource* resource);
+    void destroy() noexcept;
+    void release_shared() noexcept;
+
+    std::string_view string_view() const {
+        if (m_string_size <= max_inline_size) {
+            return std::string_view(m_data, m_string_size);
+        }
+        StringRep* rep = load<StringRep*>();
+        return std::string_view(rep->chars(), rep->size);
+    }
+
+    template<typename T>
+    T number_as() const {
+        assert(is_number() && "JsonValue is not a number");
+        if (m_type == JsonType::Int64) {
+            return static_cast<T>(load<int64_t>());
+        } else if (m_type == JsonType::Uint64) {
+            return static_cast<T>(load<uint64_t>());
+        }
+        return static_cast<T>(load<double>());
+    }
 };
 
-class ParseError {
-  public:
-    template<typename... Args>
-    ParseError(size_t line, size_t column, Args&&... args) :
-        m_line(line),
-        m_column(column) {
-        std::ostringstream oss;
-        (oss << ... << args);
-        m_message = oss.str();
+static_assert(sizeof(JsonValue) == 16, "JsonValue must stay compact");
+
+// JsonObject members that need JsonValue to be complete
+
+inline JsonObject::JsonObject(const allocator_type& allocator) :
+    m_members(allocator),
+    m_index(allocator) {}
+
+inline JsonObject::allocator_type JsonObject::get_allocator() const {
+    return m_members.get_allocator();
+}
+
+inline size_t JsonObject::size() const {
+    return m_members.size();
+}
+
+inline bool JsonObject::empty() const {
+    return m_members.empty();
+}
+
+inline JsonObject::iterator JsonObject::begin() {
+    return m_members.begin();
+}
+
+inline JsonObject::iterator JsonObject::end() {
+    return m_members.end();
+}
+
+inline JsonObject::const_iterator JsonObject::begin() const {
+    return m_members.begin();
+}
+
+inline JsonObject::const_iterator JsonObject::end() const {
+    return m_members.end();
+}
+
+inline JsonObject::iterator JsonObject::find(std::string_view key) {
+    return begin() + find_member(key);
+}
+
+inline JsonObject::const_iterator JsonObject::find(std::string_view key
+) const {
+    return begin() + find_member(key);
+}
+
+inline JsonObject::const_iterator
+JsonObject::find(std::string_view key, size_t hash) const {
+    return begin() + find_member(key, hash);
+}
+
+inline std::pair<JsonObject::iterator, bool>
+JsonObject::insert_or_assign(const JsonString& key, JsonValue value) {
+    return insert_or_assign(
+        JsonKey(key, get_allocator().resource()),
+        std::move(value)
+    );
+}
+
+inline bool JsonObject::contains(std::string_view key) const {
+    return find_member(key) != size();
+}
+
+inline void JsonObject::reserve(size_t capacity) {
+    m_members.reserve(capacity);
+}
+
+inline void JsonObject::clear() {
+    m_members.clear();
+    m_index.clear();
+}
+
+inline size_t JsonObject::find_member(std::string_view key) const {
+    if (!m_index.empty()) {
+        return find_indexed(key, std::hash<std::string_view>()(key));
+    }
+    return find_linear(key);
+}
+
+inline size_t
+JsonObject::find_member(std::string_view key, size_t hash) const {
+    if (!m_index.empty()) {
+        return find_indexed(key, hash);
     }
+    return find_linear(key);
+}
 
-    std::string_view message() const {
-        return m_message;
+inline size_t JsonObject::find_linear(std::string_view key) const {
+    for (size_t i = 0; i < m_members.size(); i++) {
+        if (m_members[i].first == key) {
+            return i;
+        }
     }
+    return m_members.size();
+}
+
+/**
+ * @brief How deeply arrays and objects may nest unless a parser is told
+ *        otherwise.
+ */
+inline constexpr size_t default_max_depth = 1024;
+
+/**
+ * @brief Bytes that must be readable past the end of a PaddedInput.
+ */
+inline constexpr size_t input_padding = 64;
+
+/**
+ * @brief A view of input followed by at least input_padding readable bytes.
+ *
+ * The padding can hold anything, it is never parsed. Knowing it is there
+ * lets the tokenizer scan the last bytes of the input with full vector
+ * loads instead of copying or checking them one at a time, which matters
+ * most when parsing many small inputs kept in larger buffers.
+ */
+class PaddedInput {
+  public:
+    /**
+     * @pre `size + input_padding` bytes starting at `data` are readable
+     */
+    PaddedInput(const char* data, size_t size) : m_json(data, size) {}
 
-    operator std::string() const {
-        return m_message;
+    std::string_view view() const {
+        return m_json;
     }
 
   private:
-    std::string m_message;
-    size_t m_line;
-    size_t m_column;
+    std::string_view m_json;
+};
+
+/**
+ * @brief A parsed JSON document that owns the memory of all its values.
+ *
+ * Every string, array and object of the document is allocated from a
+ * monotonic arena owned by the Document. Dropping the document releases the
+ * arena in one go instead of freeing each value separately, so values
+ * borrowed through root() must not outlive it. Copying a value out of the
+ * document allocates the copy from the default memory resource.
+ *
+ * A document can be parsed into again with Parser::parse_document(json,
+ * document), which keeps its memory. One kept per thread next to a Parser
+ * lets a worker parse message after message without allocating once its
+ * buffers have grown to fit them:
+ *
+ * @code
+ * thread_local brace::Parser parser;
+ * thread_local brace::Document document;
+ * TRY(parser.parse_document(message, document));
+ * @endcode
+ */
+class Document {
+  public:
+    /**
+     * @brief Creates an empty document whose root is null.
+     *
+     * @param upstream The resource the arena requests its blocks from
+     * @param initial_size Size of the first arena block in bytes
+     */
+    explicit Document(
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource(),
+        size_t initial_size = 0
+    );
+
+    ~Document();
+
+    Document(Document&& other) noexcept;
+    Document& operator=(Document&& other) noexcept;
+
+    Document(const Document&) = delete;
+    Document& operator=(const Document&) = delete;
+
+    /**
+     * @brief Retrieves the root value of the document.
+     *
+     * @return Reference to the root JsonValue, valid while the document lives
+     */
+    const JsonValue& root() const {
+        assert(m_root && "Document has been moved from");
+        return *m_root;
+    }
+
+    /**
+     * @brief Retrieves the arena values of this document are allocated from.
+     */
+    std::pmr::memory_resource* resource() const;
+
+    /**
+     * @brief Drops every value of the document, keeping its memory.
+     *
+     * The root becomes null. Memory the arena had to request beyond its
+     * first block is folded into that block, so a document reset between
+     * inputs of similar size stops requesting memory from upstream.
+     */
+    void reset();
+
+  private:
+    friend class Parser;
+
+    class Arena;
+
+    std::unique_ptr<Arena> m_arena;
+    // Lives inside the arena and is never destroyed: releasing the arena
+    // frees the whole tree at once
+    JsonValue* m_root {nullptr};
+
+    void set_root(JsonValue&& value);
+};
+
+/**
+ * @brief Receives the records of Parser::parse_many() in input order.
+ *
+ * Malformed records are passed on as errors located within their line.
+ *
+ * @param line The 1-based line of the input the record is on
+ * @param record The parsed record or why it is malformed
+ * @return Whether to go on with the next record
+ */
+using RecordHandler =
+    std::function<bool(size_t line, Result<JsonValue, ParseError>&& record)>;
+
+/**
+ * @brief What a parse went through, see Parser::stats().
+ *
+ * Only collected when brace is built with BRACE_ENABLE_STATS defined (the
+ * BRACE_ENABLE_STATS CMake option), every field stays zero otherwise and
+ * parsing costs nothing extra. Phase times are estimated from a random
+ * sample of about one in 32 tokens, numbers and containers, since timing
+ * each of them would take longer than parsing them.
+ *
+ * Allocations are those made for parsed values, from the parser's memory
+ * resource or a document's arena. Allocations made by SaxHandlers or for
+ * the members parse_into() fills are not counted. With several threads the
+ * counts and times of all of them are added up.
+ */
+struct ParseStats {
+#ifdef BRACE_ENABLE_STATS
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    // Bytes of input the tokenizer went over
+    size_t bytes_scanned {0};
+
+    // Tokens read, by type
+    size_t keywords {0};
+    size_t numbers {0};
+    size_t strings {0};
+    size_t braces {0};  // '{' and '}'
+    size_t brackets {0};  // '[' and ']'
+    size_t colons {0};
+    size_t commas {0};
+    size_t punctuation {0};
+
+    // Deepest nesting of arrays and objects, 0 for a scalar. parse_into()
+    // counts the structs and vectors it reads into as well.
+    size_t max_depth {0};
+
+    size_t allocations {0};
+    size_t allocated_bytes {0};
+
+    // Time spent scanning tokens
+    std::chrono::nanoseconds tokenize_time {0};
+    // Time spent converting number literals
+    std::chrono::nanoseconds number_time {0};
+    // Time spent completing arrays and objects, which is where a DOM is
+    // built and object members are indexed
+    std::chrono::nanoseconds container_time {0};
+
+    size_t tokens() const {
+        return keywords + numbers + strings + braces + brackets + colons
+            + commas + punctuation;
+    }
+
+    ParseStats& operator+=(const ParseStats& other);
 };
 
 /**
@@ -368,6 +1251,12 @@ class ParseError {
  * - Parsing JSON arrays
  * - Handling null, boolean, number, and string values
  * - Error detection and reporting
+ *
+ * A parser keeps its tokenizer, structural index and value stacks between
+ * parses and only clears them, so reusing one parser for many inputs saves
+ * growing them again each time. Parsers are not thread-safe; keep one per
+ * thread, for example as a `thread_local`, along with a Document to parse
+ * into (see Document).
  */
 class Parser {
   public:
@@ -382,29 +1271,361 @@ class Parser {
      *         - A successfully parsed JsonValue on success
      *         - A ParseError describing the parsing failure on error
      *
-     * @note This method is the primary interface for JSON parsing.
+     * @note This method is the primary interface for JSON parsing. Tokens
+     *       are pulled from the tokenizer one at a time while the value is
+     *       being built, so no token buffer is kept alongside the result.
+     */
+    Result<JsonValue, ParseError> parse(std::string_view json);
+
+    Result<JsonValue, ParseError> parse(const char* data, size_t size) {
+        return parse(std::string_view(data, size));
+    }
+
+    /**
+     * @brief Parses a padded input into a JsonValue.
+     *
+     * Same as parse(), scanning the end of the input in place.
+     */
+    Result<JsonValue, ParseError> parse(PaddedInput input);
+
+    /**
+     * @brief Parses a JSON-formatted string into an arena-backed Document.
+     *
+     * All values of the result live in the document's arena, which requests
+     * its blocks from the parser's memory resource.
+     *
+     * @param json The JSON-formatted string to parse
+     * @return The parsed Document on success, a ParseError otherwise
+     */
+    Result<Document, ParseError> parse_document(std::string_view json);
+    Result<Document, ParseError> parse_document(PaddedInput input);
+
+    /**
+     * @brief Parses a JSON-formatted string into an existing Document.
+     *
+     * The document is reset first and reuses its arena, so parsing into the
+     * same document over and over stops allocating once the arena fits the
+     * inputs. The document keeps its own upstream resource.
+     *
+     * @param json The JSON-formatted string to parse
+     * @param document The document to parse into, left with a null root on
+     *        error
+     * @return Unit on success, a ParseError otherwise
      */
-    Result<JsonValue, ParseError> parse(const std::string& json);
+    Result<Unit, ParseError>
+    parse_document(std::string_view json, Document& document);
+    Result<Unit, ParseError>
+    parse_document(PaddedInput input, Document& document);
+
+    /**
+     * @brief Parses a JSON file into a JsonValue.
+     *
+     * Regular files are memory-mapped and parsed straight from the mapped
+     * pages instead of being read into a string first. The mapping is
+     * released before returning, the values of the result own their data.
+     *
+     * @param path The path of the file to parse
+     * @return The parsed JsonValue on success, a ParseError otherwise. Errors
+     *         reading the file are reported at line 0.
+     */
+    Result<JsonValue, ParseError> parse_file(const std::string& path);
+
+    /**
+     * @brief Prepares a JSON-formatted string for on-demand access.
+     *
+     * Only the structure of the input is checked up front, values are read
+     * when they are accessed. Defined in brace/lazy.h, which must be
+     * included to use it.
+     *
+     * @param json The JSON-formatted string to parse, must outlive the result
+     * @return The LazyDocument on success, a ParseError otherwise
+     */
+    Result<LazyDocument, ParseError> parse_lazy(std::string_view json);
+    Result<LazyDocument, ParseError> parse_lazy(const char* json);
+    Result<LazyDocument, ParseError> parse_lazy(std::string&& json) = delete;
+
+    /**
+     * @brief Parses a JSON-formatted string on several threads.
+     *
+     * A large top-level array is cut at commas between its elements, found
+     * with the structural index, and each range is parsed into a slice of
+     * its own by a worker. The slices are then moved into the result in
+     * order. Other inputs are parsed like parse() does.
+     *
+     * @param json The JSON-formatted string to parse
+     * @param threads How many threads to parse on, 0 for one per core. The
+     *        memory resource must be thread-safe when this is not 1.
+     * @return The parsed JsonValue on success, a ParseError otherwise
+     */
+    Result<JsonValue, ParseError>
+    parse_parallel(std::string_view json, size_t threads = 0);
+
+    /**
+     * @brief Parses newline-delimited JSON, one record per line.
+     *
+     * Blank lines are skipped. The parser's buffers are reused from one
+     * record to the next, and with more than one thread the input is split
+     * into batches of lines that are parsed concurrently, each worker with
+     * a parser of its own. Records still reach `handler` one at a time, in
+     * input order, on the calling thread.
+     *
+     * @param input The records, separated by line feeds
+     * @param handler Called with every record until it returns false
+     * @param threads How many threads to parse on, 0 for one per core. The
+     *        memory resource must be thread-safe when this is not 1.
+     * @return The number of records passed to the handler
+     */
+    size_t parse_many(
+        std::string_view input,
+        const RecordHandler& handler,
+        size_t threads = 1
+    );
+
+    /**
+     * @brief Extracts the values at a set of paths from a JSON string.
+     *
+     * Reads the input as a stream of events, like parse_sax(), only
+     * building the values found at the paths. Scanning stops as soon as
+     * every path has been found or has been passed without a match, the
+     * rest of the input is neither read nor validated. With duplicate keys
+     * the first member is the one found.
+     *
+     * @param json The JSON-formatted string to search
+     * @param paths The paths to look for, see brace/path.h
+     * @param values Set to the value found at each path, or to nothing
+     * @return The number of paths found, or a ParseError if the input read
+     *         up to then is malformed
+     */
+    Result<size_t, ParseError> parse_paths(
+        std::string_view json,
+        const std::vector<Path>& paths,
+        std::vector<std::optional<JsonValue>>& values
+    );
+
+    /**
+     * @brief Sets the memory resource parsed values are allocated from.
+     *
+     * Values returned by parse() allocate from this resource directly and
+     * documents returned by parse_document() draw their arena blocks from
+     * it. The resource must outlive everything parsed with it.
+     *
+     * @param resource The resource to use, the default resource if null
+     */
+    void set_memory_resource(std::pmr::memory_resource* resource) {
+        m_resource = resource ? resource : std::pmr::get_default_resource();
+    }
+
+    /**
+     * @brief Retrieves the memory resource parsed values are allocated from.
+     */
+    std::pmr::memory_resource* memory_resource() const {
+        return m_resource;
+    }
+
+    /**
+     * @brief Sets whether documents intern the keys of their objects.
+     *
+     * Interned keys are stored once per document, along with their hash,
+     * and shared by all the members with that key. Arrays of records with
+     * the same keys then take much less memory, and large objects are
+     * indexed without hashing their keys again. Only documents intern keys,
+     * since every value referring to a key must go before the key does.
+     *
+     * @param intern Whether documents parsed from now on intern keys, off
+     *        by default
+     */
+    void set_intern_keys(bool intern) {
+        m_intern_keys = intern;
+    }
+
+    /**
+     * @brief Sets whether equal string values are stored once.
+     *
+     * Strings too long to be stored inline, of up to 64 bytes, are
+     * looked up in a table of those seen so far and refer to the first
+     * copy, so repeated names, dates and enum-like values take memory once.
+     * Documents share one table for all their values, shared values one for
+     * each call to parse(), parse_many() or any other. Values that are
+     * neither own their strings and are not interned. The table is bounded,
+     * strings past its first few thousand are stored separately again.
+     *
+     * @param intern Whether documents and shared values parsed from now on
+     *        intern strings, off by default
+     */
+    void set_intern_strings(bool intern) {
+        m_intern_strings = intern;
+    }
+
+    /**
+     * @brief Sets whether parsed values are shared.
+     *
+     * The strings, arrays and objects of shared values are kept in
+     * reference counted blocks, so copying a parsed value or any value in
+     * it takes constant time (see JsonValue::share()). Applies to the
+     * values returned by parse(), parse_file(), parse_parallel(),
+     * parse_many() and parse_paths() and to JsonValue members filled by
+     * parse_into(), never to documents. Values that go to other threads
+     * need a thread-safe memory resource.
+     *
+     * @param shared Whether values parsed from now on are shared, off by
+     *        default
+     */
+    void set_shared_values(bool shared) {
+        m_shared_values = shared;
+    }
+
+    /**
+     * @brief Sets how deeply arrays and objects may nest.
+     *
+     * Open containers are kept on a stack of the parser's own rather than
+     * recursed into, so deep input does not exhaust the native stack while
+     * it is parsed. The limit bounds the depth of the values returned,
+     * which are copied, written out and destroyed recursively, for threads
+     * with small stacks. parse_into() does recurse, once per level, and is
+     * bounded by the limit the same way. Input nesting past it is rejected
+     * with ErrorCode::DepthExceeded.
+     *
+     * @param depth The number of containers a value may be nested in, a
+     *        depth of 0 only accepts scalars. default_max_depth by default.
+     */
+    void set_max_depth(size_t depth) {
+        m_max_depth = depth;
+    }
+
+    size_t max_depth() const {
+        return m_max_depth;
+    }
+
+    /**
+     * @brief Retrieves what the last parse went through.
+     *
+     * Covers the last call to parse(), parse_document(), parse_file(),
+     * parse_sax(), parse_into(), parse_paths(), parse_many() or
+     * parse_parallel(), whether it succeeded or not. Lazy documents are
+     * not covered. Always zero unless brace is built with stats, see
+     * ParseStats.
+     */
+    const ParseStats& stats() const {
+        return m_stats;
+    }
+
+    /**
+     * @brief Parses a JSON-formatted string into a stream of events.
+     *
+     * Reports every value to `handler` as it is read instead of building a
+     * DOM, so memory use does not depend on the size of the input. Defined
+     * in brace/sax.h, which must be included to use it.
+     *
+     * @param json The JSON-formatted string to parse
+     * @param handler A SaxHandler receiving the events
+     * @return Unit on success, a ParseError if the input is malformed or the
+     *         handler stopped parsing
+     */
+    template<typename Handler>
+    Result<Unit, ParseError> parse_sax(std::string_view json, Handler& handler);
+
+    template<typename Handler>
+    Result<Unit, ParseError> parse_sax(PaddedInput input, Handler& handler);
+
+    /**
+     * @brief Parses a JSON-formatted string straight into a C++ object.
+     *
+     * Structs with members listed by BRACE_FIELDS are filled from the
+     * object keys of the same name, no JsonValue is built along the way.
+     * Keys no member is named after are skipped and members whose key is
+     * missing keep their value. Defined in brace/fields.h, which must be
+     * included to use it.
+     *
+     * @param json The JSON-formatted string to parse
+     * @param out The object to parse into, partly filled on error
+     * @return Unit on success, a ParseError if the input is malformed or
+     *         does not match the type of `out`
+     */
+    template<typename T>
+    Result<Unit, ParseError> parse_into(std::string_view json, T& out);
+
+    template<typename T>
+    Result<Unit, ParseError> parse_into(PaddedInput input, T& out);
 
   private:
-    std::vector<::priv::brace::Token> m_tokens;
-    size_t m_current;
+    std::pmr::memory_resource* m_resource {std::pmr::get_default_resource()};
+    bool m_intern_keys {false};
+    bool m_intern_strings {false};
+    bool m_shared_values {false};
+    size_t m_max_depth {default_max_depth};
+    ::priv::brace::Tokenizer m_tokenizer;
+    std::string_view m_json;
+    ::priv::brace::Token m_token;
+    // Decoded contents of the last string literal with escapes
+    std::string m_scratch;
+    // Members and elements of the objects and arrays being parsed
+    std::vector<JsonObject::value_type> m_member_stack;
+    std::vector<JsonValue> m_element_stack;
+    // For each container being built, whether it is an object
+    std::vector<bool> m_container_stack;
+    // Containers open in the input, for the SaxDriver
+    std::vector<::priv::brace::SaxFrame> m_frame_stack;
+    // Interns the shared strings of the call in progress, see StringScope
+    ::priv::brace::StringTable* m_strings {nullptr};
+    ParseStats m_stats;
+
+    template<typename Handler>
+    friend class ::priv::brace::SaxDriver;
+    friend class ::priv::brace::ValueReader;
 
     const ::priv::brace::Token& peek() const {
-        return m_tokens[m_current];
+        return m_token;
     }
 
-    const ::priv::brace::Token& advance() {
-        return m_tokens[m_current++];
-    }
+    Result<::priv::brace::Token, ParseError> advance();
 
     bool is_at_end() const {
-        return m_current >= m_tokens.size();
+        return m_token.type == ::priv::brace::TokenType::Eof;
     }
 
-    Result<JsonValue, ParseError> parse_value();
-    Result<JsonObject, ParseError> parse_object();
-    Result<JsonArray, ParseError> parse_array();
+    ParseError error_at(
+        const ::priv::brace::Token& token,
+        ErrorCode code,
+        std::string_view detail = {}
+    ) const {
+        return error_at(token.offset, code, detail);
+    }
+    ParseError
+    error_at(size_t offset, ErrorCode code, std::string_view detail = {}) const;
+
+    // Rewinds to `offset` of `json` and reads the first token there
+    Result<Unit, ParseError>
+    start(std::string_view json, size_t offset = 0, bool padded = false);
+    // Checks whatever follows the parsed value
+    Result<Unit, ParseError> finish();
+
+    template<typename Handler>
+    Result<Unit, ParseError>
+    run_sax(std::string_view json, bool padded, Handler& handler);
+    template<typename T>
+    Result<Unit, ParseError> read_into(std::string_view json, bool padded, T& out);
+
+    Result<JsonValue, ParseError> parse_root(
+        std::string_view json,
+        std::pmr::memory_resource* resource,
+        bool padded = false,
+        ::priv::brace::KeyTable* keys = nullptr,
+        bool shared = false,
+        ::priv::brace::StringTable* strings = nullptr
+    );
+    // The table to intern the keys of `document` in, if keys are interned
+    ::priv::brace::KeyTable* document_keys(Document& document) const;
+    // Likewise for its strings
+    ::priv::brace::StringTable* document_strings(Document& document) const;
+    Result<Document, ParseError>
+    build_document(std::string_view json, bool padded);
+    Result<Unit, ParseError>
+    fill_document(std::string_view json, bool padded, Document& document);
+    // Parses the elements of an array from `begin` up to the ',' or ']'
+    // at `end`, appending them to `out`
+    Result<Unit, ParseError>
+    parse_elements(std::string_view json, size_t begin, size_t end, JsonArray& out);
+    std::string_view decode_string(const ::priv::brace::Token& token);
 };
 
 }  // namespace brace
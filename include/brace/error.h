@@ -0,0 +1,127 @@
+#ifndef __BRACE_ERROR_H__
+#define __BRACE_ERROR_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace brace {
+
+/**
+ * @brief What went wrong in a ParseError.
+ */
+enum class ErrorCode : uint8_t {
+    // Malformed tokens
+    UnexpectedCharacter,
+    UnknownKeyword,
+    InvalidNumber,
+    UnterminatedString,
+    InvalidEscape,
+    InvalidUnicodeEscape,
+    InvalidUtf8,
+    // Malformed structure
+    UnexpectedToken,
+    UnexpectedEnd,
+    ExpectedKey,
+    ExpectedColon,
+    ExpectedCommaOrBrace,
+    ExpectedCommaOrBracket,
+    NumberOutOfRange,
+    DepthExceeded,
+    // Values not matching the type of what they are parsed into
+    ExpectedString,
+    ExpectedBool,
+    ExpectedNumber,
+    ExpectedInteger,
+    ExpectedArray,
+    ExpectedObject,
+    // A SaxHandler returned false
+    Cancelled,
+    // More than the 32-bit offsets of lazy documents and snapshots reach
+    InputTooLarge,
+    // A malformed JSON Pointer passed to Path::compile()
+    InvalidPointer,
+    // Failing to read or write a file, the detail says why
+    Io,
+    // A file that is not a snapshot of this version and byte order
+    InvalidSnapshot,
+};
+
+/**
+ * @brief Retrieves a short, static description of an error code such as
+ *        "Expected ':' after key in object".
+ */
+const char* describe(ErrorCode code);
+
+/**
+ * @brief A failure to parse, located within the input.
+ *
+ * Errors are only an error code and where it happened, plus a detail such
+ * as the offending token when there is one. Short details are stored
+ * inline, so malformed input is rejected without allocating. The message
+ * is only put together when asked for.
+ */
+class ParseError {
+  public:
+    /**
+     * @param offset Offset of the problem in the input
+     * @param line 1-based line of the offset, or 0 for errors that are not
+     *        about the contents of the input, such as failing to read it
+     * @param column 1-based column of the offset
+     * @param detail The offending token or other context, copied
+     */
+    ParseError(
+        ErrorCode code,
+        size_t offset,
+        size_t line,
+        size_t column,
+        std::string_view detail = {}
+    ) :
+        m_detail(detail),
+        m_offset(offset),
+        m_line(line),
+        m_column(column),
+        m_code(code) {}
+
+    ErrorCode code() const {
+        return m_code;
+    }
+
+    size_t offset() const {
+        return m_offset;
+    }
+
+    size_t line() const {
+        return m_line;
+    }
+
+    size_t column() const {
+        return m_column;
+    }
+
+    std::string_view detail() const {
+        return m_detail;
+    }
+
+    /**
+     * @brief Formats the error, for example
+     *        "Unexpected token: ] at line 3, column 7".
+     */
+    std::string message() const;
+
+    operator std::string() const {
+        return message();
+    }
+
+  private:
+    std::string m_detail;
+    size_t m_offset;
+    size_t m_line;
+    size_t m_column;
+    ErrorCode m_code;
+};
+
+}  // namespace brace
+
+#endif
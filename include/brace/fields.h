@@ -0,0 +1,551 @@
+#ifndef __BRACE_FIELDS_H__
+#define __BRACE_FIELDS_H__
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../priv/brace/dom_builder.h"
+#include "brace.h"
+#include "sax.h"
+
+/**
+ * @brief Lists the members of a struct that Parser::parse_into() fills.
+ *
+ * Each member is read from the object key of the same name. Must be used
+ * at namespace scope, in the namespace of the struct:
+ *
+ * @code
+ * struct User {
+ *     std::string name;
+ *     std::vector<uint32_t> groups;
+ *     std::optional<std::string> email;
+ * };
+ * BRACE_FIELDS(User, name, groups, email)
+ * @endcode
+ *
+ * Members may be booleans, numbers, strings, JsonValue, other structs with
+ * BRACE_FIELDS, or std::optional and std::vector of any of these. Up to 32
+ * members can be listed.
+ */
+#define BRACE_FIELDS(Type, ...)                                              \
+    [[maybe_unused]] inline constexpr auto brace_fields(const Type*) {       \
+        return std::make_tuple(BRACE_PRIV_EXPAND(BRACE_PRIV_CONCAT(          \
+            BRACE_PRIV_FIELDS_,                                              \
+            BRACE_PRIV_COUNT(__VA_ARGS__)                                    \
+        )(Type, __VA_ARGS__)));                                              \
+    }
+
+// The rest expands one ::priv::brace::field() per member. Every use of
+// __VA_ARGS__ goes through BRACE_PRIV_EXPAND for MSVC's preprocessor.
+#define BRACE_PRIV_EXPAND(x) x
+#define BRACE_PRIV_CONCAT_(a, b) a##b
+#define BRACE_PRIV_CONCAT(a, b) BRACE_PRIV_CONCAT_(a, b)
+#define BRACE_PRIV_COUNT(...)                                                \
+    BRACE_PRIV_EXPAND(BRACE_PRIV_NTH(                                        \
+        __VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, \
+        18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1        \
+    ))
+#define BRACE_PRIV_NTH(                                                      \
+    _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16,   \
+    _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30,    \
+    _31, _32, n, ...                                                         \
+)                                                                            \
+    n
+
+#define BRACE_PRIV_FIELD(T, m) ::priv::brace::field(#m, &T::m)
+#define BRACE_PRIV_FIELDS_1(T, m) BRACE_PRIV_FIELD(T, m)
+#define BRACE_PRIV_FIELDS_2(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_1(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_3(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_2(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_4(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_3(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_5(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_4(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_6(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_5(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_7(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_6(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_8(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_7(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_9(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_8(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_10(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_9(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_11(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_10(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_12(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_11(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_13(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_12(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_14(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_13(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_15(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_14(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_16(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_15(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_17(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_16(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_18(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_17(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_19(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_18(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_20(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_19(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_21(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_20(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_22(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_21(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_23(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_22(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_24(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_23(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_25(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_24(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_26(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_25(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_27(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_26(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_28(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_27(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_29(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_28(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_30(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_29(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_31(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_30(T, __VA_ARGS__))
+#define BRACE_PRIV_FIELDS_32(T, m, ...) \
+    BRACE_PRIV_FIELD(T, m), BRACE_PRIV_EXPAND(BRACE_PRIV_FIELDS_31(T, __VA_ARGS__))
+
+namespace priv::brace {
+
+template<typename Type, typename Member>
+struct Field {
+    std::string_view name;
+    Member Type::*member;
+};
+
+template<typename Type, typename Member>
+constexpr Field<Type, Member> field(std::string_view name, Member Type::*member) {
+    return {name, member};
+}
+
+// FNV-1a, with the seed mixed into the offset basis
+constexpr uint32_t hash_key(std::string_view key, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (char c : key) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+template<size_t Count>
+constexpr bool distinct(const std::array<std::string_view, Count>& names) {
+    for (size_t i = 0; i < Count; i++) {
+        for (size_t j = i + 1; j < Count; j++) {
+            if (names[i] == names[j]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Finds a seed that sends every name to a slot of its own
+template<size_t Slots, size_t Count>
+constexpr uint32_t find_seed(const std::array<std::string_view, Count>& names) {
+    for (uint32_t seed = 0;; seed++) {
+        bool taken[Slots] = {};
+        bool perfect = true;
+        for (std::string_view name : names) {
+            size_t slot = hash_key(name, seed) & (Slots - 1);
+            if (taken[slot]) {
+                perfect = false;
+                break;
+            }
+            taken[slot] = true;
+        }
+        if (perfect) {
+            return seed;
+        }
+    }
+}
+
+template<typename T, typename = void>
+struct has_fields: std::false_type {};
+
+template<typename T>
+struct has_fields<T, std::void_t<decltype(brace_fields(std::declval<const T*>()))>>:
+    std::true_type {};
+
+/**
+ * The members listed with BRACE_FIELDS for `T`, and a perfect hash table
+ * from their names to their positions built at compile time. Looking up a
+ * key hashes it once and compares it with a single name.
+ */
+template<typename T>
+struct FieldTable {
+    static constexpr auto fields = brace_fields(static_cast<const T*>(nullptr));
+    static constexpr size_t count = std::tuple_size_v<decltype(fields)>;
+
+    static constexpr std::array<std::string_view, count> names = std::apply(
+        [](const auto&... field) {
+            return std::array<std::string_view, count> {field.name...};
+        },
+        fields
+    );
+    static_assert(distinct(names), "BRACE_FIELDS lists a member twice");
+
+    // A quarter full at most, so that a seed is found quickly
+    static constexpr size_t slots = [] {
+        size_t size = 1;
+        while (size < count * 4) {
+            size *= 2;
+        }
+        return size;
+    }();
+    static constexpr uint32_t seed = find_seed<slots>(names);
+
+    static constexpr std::array<uint8_t, slots> positions = [] {
+        std::array<uint8_t, slots> table {};
+        for (uint8_t& position : table) {
+            position = count;
+        }
+        for (size_t i = 0; i < count; i++) {
+            table[hash_key(names[i], seed) & (slots - 1)] = static_cast<uint8_t>(i);
+        }
+        return table;
+    }();
+
+    // The position of the member named `key`, `count` if there is none
+    static size_t find(std::string_view key) {
+        size_t position = positions[hash_key(key, seed) & (slots - 1)];
+        return position < count && names[position] == key ? position : count;
+    }
+};
+
+template<typename T>
+struct is_optional: std::false_type {};
+
+template<typename T>
+struct is_optional<std::optional<T>>: std::true_type {};
+
+template<typename T>
+struct is_vector: std::false_type {};
+
+template<typename T, typename Allocator>
+struct is_vector<std::vector<T, Allocator>>: std::true_type {};
+
+template<typename T>
+struct is_string: std::false_type {};
+
+template<typename Traits, typename Allocator>
+struct is_string<std::basic_string<char, Traits, Allocator>>: std::true_type {};
+
+template<typename T>
+inline constexpr bool dependent_false = false;
+
+/**
+ * Reads values from the token stream of a Parser straight into C++ objects
+ * of the matching type, without building JsonValues first.
+ */
+class ValueReader {
+  public:
+    explicit ValueReader(::brace::Parser& parser) : m_parser(parser) {}
+
+    template<typename T>
+    ::brace::Result<::brace::Unit, ::brace::ParseError> read(T& out);
+
+  private:
+    template<typename T, typename E>
+    using Result = ::brace::Result<T, E>;
+    using ParseError = ::brace::ParseError;
+    using ErrorCode = ::brace::ErrorCode;
+    using Unit = ::brace::Unit;
+
+    // Skips over values of keys no member is named after
+    struct Skipper: ::brace::SaxHandler<Skipper> {};
+
+    ::brace::Parser& m_parser;
+    // Arrays and objects the value being read is nested in
+    size_t m_depth {0};
+
+    // Counts a container being opened, past the parser's maximum depth it
+    // is rejected like parse() does
+    Result<Unit, ParseError> enter(const Token& open);
+    Result<Unit, ParseError> read_bool(bool& out);
+    template<typename T>
+    Result<Unit, ParseError> read_number(T& out);
+    template<typename T>
+    Result<Unit, ParseError> read_vector(T& out);
+    template<typename T>
+    Result<Unit, ParseError> read_object(T& out);
+    Result<Unit, ParseError> read_value(::brace::JsonValue& out);
+    Result<Unit, ParseError> skip();
+
+    template<typename T, size_t... I>
+    Result<Unit, ParseError>
+    read_member(T& out, size_t position, std::index_sequence<I...>);
+};
+
+template<typename T>
+auto ValueReader::read(T& out) -> Result<Unit, ParseError> {
+    if constexpr (std::is_same_v<T, bool>) {
+        return read_bool(out);
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        return read_number(out);
+    } else if constexpr (is_string<T>::value) {
+        TRY_ASSIGN(token, m_parser.advance());
+        if (token.type != TokenType::StringLiteral) {
+            return m_parser.error_at(token, ErrorCode::ExpectedString);
+        }
+        out.assign(m_parser.decode_string(token));
+        return Unit {};
+    } else if constexpr (is_optional<T>::value) {
+        const Token& token = m_parser.peek();
+        if (token.type == TokenType::Keyword && token.lexeme == "null") {
+            TRY(m_parser.advance());
+            out.reset();
+            return Unit {};
+        }
+        if (!out) {
+            out.emplace();
+        }
+        return read(*out);
+    } else if constexpr (is_vector<T>::value) {
+        return read_vector(out);
+    } else if constexpr (std::is_same_v<T, ::brace::JsonValue>) {
+        return read_value(out);
+    } else if constexpr (has_fields<T>::value) {
+        return read_object(out);
+    } else {
+        static_assert(
+            dependent_false<T>,
+            "Type can not be parsed into, list its members with BRACE_FIELDS"
+        );
+    }
+}
+
+inline auto ValueReader::enter(const Token& open) -> Result<Unit, ParseError> {
+    if (m_depth >= m_parser.m_max_depth) {
+        return m_parser.error_at(open, ErrorCode::DepthExceeded);
+    }
+    m_depth++;
+    if constexpr (::brace::ParseStats::enabled) {
+        size_t& deepest = m_parser.m_stats.max_depth;
+        deepest = std::max(deepest, m_depth);
+    }
+    return Unit {};
+}
+
+inline auto ValueReader::read_bool(bool& out) -> Result<Unit, ParseError> {
+    TRY_ASSIGN(token, m_parser.advance());
+    if (token.type != TokenType::Keyword || token.lexeme == "null") {
+        return m_parser.error_at(token, ErrorCode::ExpectedBool);
+    }
+    out = token.lexeme == "true";
+    return Unit {};
+}
+
+template<typename T>
+auto ValueReader::read_number(T& out) -> Result<Unit, ParseError> {
+    TRY_ASSIGN(token, m_parser.advance());
+    if (token.type != TokenType::NumberLiteral) {
+        return m_parser.error_at(token, ErrorCode::ExpectedNumber);
+    }
+    Number number;
+    bool parsed;
+    {
+        PhaseTimer timer(m_parser.m_stats.number_time);
+        parsed = parse_number(token, number);
+    }
+    if (!parsed) {
+        return m_parser.error_at(token, ErrorCode::NumberOutOfRange, token.lexeme);
+    }
+
+    if constexpr (std::is_floating_point_v<T>) {
+        switch (number.kind) {
+            case NumberKind::Int64: out = static_cast<T>(number.int64); break;
+            case NumberKind::Uint64: out = static_cast<T>(number.uint64); break;
+            default: out = static_cast<T>(number.number); break;
+        }
+        return Unit {};
+    } else {
+        using Limits = std::numeric_limits<T>;
+        bool fits;
+        if (number.kind == NumberKind::Int64) {
+            fits = std::is_signed_v<T> && number.int64 >= int64_t(Limits::min());
+        } else if (number.kind == NumberKind::Uint64) {
+            fits = number.uint64 <= uint64_t(Limits::max());
+        } else {
+            return m_parser.error_at(token, ErrorCode::ExpectedInteger, token.lexeme);
+        }
+        if (!fits) {
+            return m_parser.error_at(token, ErrorCode::NumberOutOfRange, token.lexeme);
+        }
+        out = number.kind == NumberKind::Int64 ? static_cast<T>(number.int64)
+                                               : static_cast<T>(number.uint64);
+        return Unit {};
+    }
+}
+
+template<typename T>
+auto ValueReader::read_vector(T& out) -> Result<Unit, ParseError> {
+    TRY_ASSIGN(open, m_parser.advance());  // Consume '['
+    if (open.type != TokenType::LeftBracket) {
+        return m_parser.error_at(open, ErrorCode::ExpectedArray);
+    }
+    TRY(enter(open));
+
+    // Clearing keeps the capacity when parsing into the same object again
+    out.clear();
+    while (m_parser.peek().type != TokenType::RightBracket) {
+        if constexpr (std::is_same_v<typename T::value_type, bool>) {
+            bool element;
+            TRY(read_bool(element));
+            out.push_back(element);
+        } else {
+            TRY(read(out.emplace_back()));
+        }
+
+        const Token& next = m_parser.peek();
+        if (next.type == TokenType::Comma) {
+            TRY(m_parser.advance());  // Consume ','
+        } else if (next.type != TokenType::RightBracket) {
+            return m_parser.error_at(next, ErrorCode::ExpectedCommaOrBracket);
+        }
+    }
+
+    TRY(m_parser.advance());  // Consume ']'
+    m_depth--;
+    return Unit {};
+}
+
+template<typename T>
+auto ValueReader::read_object(T& out) -> Result<Unit, ParseError> {
+    using Table = FieldTable<T>;
+
+    TRY_ASSIGN(open, m_parser.advance());  // Consume '{'
+    if (open.type != TokenType::LeftBrace) {
+        return m_parser.error_at(open, ErrorCode::ExpectedObject);
+    }
+    TRY(enter(open));
+
+    while (m_parser.peek().type != TokenType::RightBrace) {
+        TRY_ASSIGN(key, m_parser.advance());  // Key
+        if (key.type != TokenType::StringLiteral) {
+            return m_parser.error_at(key, ErrorCode::ExpectedKey);
+        }
+        // Looked up before the value is read, which may reuse the
+        // buffer the key was decoded into
+        size_t position = Table::find(m_parser.decode_string(key));
+
+        TRY_ASSIGN(colon, m_parser.advance());
+        if (colon.type != TokenType::Colon) {
+            return m_parser.error_at(colon, ErrorCode::ExpectedColon);
+        }
+
+        if (position == Table::count) {
+            TRY(skip());
+        } else {
+            TRY(read_member(out, position, std::make_index_sequence<Table::count>()));
+        }
+
+        const Token& next = m_parser.peek();
+        if (next.type == TokenType::Comma) {
+            TRY(m_parser.advance());  // Consume ','
+        } else if (next.type != TokenType::RightBrace) {
+            return m_parser.error_at(next, ErrorCode::ExpectedCommaOrBrace);
+        }
+    }
+
+    TRY(m_parser.advance());  // Consume '}'
+    m_depth--;
+    return Unit {};
+}
+
+template<typename T, size_t... I>
+auto ValueReader::read_member(T& out, size_t position, std::index_sequence<I...>)
+    -> Result<Unit, ParseError> {
+    // Unrolled into one comparison per member, which compilers turn into
+    // a jump table
+    Result<Unit, ParseError> result = Unit {};
+    (void)((position == I
+            && (result = read(out.*std::get<I>(FieldTable<T>::fields).member),
+                true))
+           || ...);
+    return result;
+}
+
+inline auto ValueReader::read_value(::brace::JsonValue& out)
+    -> Result<Unit, ParseError> {
+    DomBuilder builder(
+        m_parser.m_resource,
+        m_parser.m_member_stack,
+        m_parser.m_element_stack,
+        m_parser.m_container_stack,
+        nullptr,
+        m_parser.m_shared_values,
+        m_parser.m_strings
+    );
+    SaxDriver<DomBuilder> driver(m_parser, builder, m_depth);
+    auto parsed = driver.parse_value();
+    if (parsed.is_err()) {
+        // Like Parser::parse_root(), drop the values of the failed parse
+        m_parser.m_member_stack.clear();
+        m_parser.m_element_stack.clear();
+        m_parser.m_container_stack.clear();
+        return parsed;
+    }
+    out = builder.take_root();
+    return Unit {};
+}
+
+inline auto ValueReader::skip() -> Result<Unit, ParseError> {
+    Skipper skipper;
+    SaxDriver<Skipper> driver(m_parser, skipper, m_depth);
+    return driver.parse_value();
+}
+
+}  // namespace priv::brace
+
+namespace brace {
+
+template<typename T>
+Result<Unit, ParseError> Parser::parse_into(std::string_view json, T& out) {
+    return read_into(json, false, out);
+}
+
+template<typename T>
+Result<Unit, ParseError> Parser::parse_into(PaddedInput input, T& out) {
+    return read_into(input.view(), true, out);
+}
+
+template<typename T>
+Result<Unit, ParseError>
+Parser::read_into(std::string_view json, bool padded, T& out) {
+    ::priv::brace::StatsScope scope(m_stats);
+    // Shared by the JsonValue members read
+    ::priv::brace::StringScope strings(
+        m_strings,
+        m_resource,
+        m_shared_values && m_intern_strings
+    );
+    TRY(start(json, 0, padded));
+    ::priv::brace::ValueReader reader(*this);
+    TRY(reader.read(out));
+    return finish();
+}
+
+}  // namespace brace
+
+#endif
@@ -0,0 +1,221 @@
+#ifndef __BRACE_LAZY_H__
+#define __BRACE_LAZY_H__
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "brace.h"
+
+namespace brace {
+
+class LazyValue;
+
+/**
+ * @brief A document parsed on demand.
+ *
+ * Parsing only records where each token starts, using the structural
+ * index, and checks that brackets, colons and commas are where they belong.
+ * Values are read from the input when they are accessed through a
+ * LazyValue, and unvisited containers are jumped over in one step.
+ *
+ * The contents of strings, numbers and keywords are only validated when
+ * they are read, so get() reports errors in parts of the input that were
+ * never looked at before. The input must outlive the document.
+ */
+class LazyDocument {
+  public:
+    /**
+     * @brief Retrieves a cursor to the root value.
+     */
+    LazyValue root() const;
+
+  private:
+    friend class LazyValue;
+    friend class Parser;
+
+    std::string_view m_json;
+    // Offset of every token in the input
+    std::vector<uint32_t> m_structurals;
+    // For each opening bracket, the position of its closing bracket in
+    // m_structurals
+    std::vector<uint32_t> m_jumps;
+
+    Result<Unit, ParseError> build(std::string_view json, size_t max_depth);
+    Result<Unit, ParseError> validate(size_t max_depth);
+
+    char first_byte(size_t position) const {
+        return m_json[m_structurals[position]];
+    }
+
+    // Position of the first token after the value at `position`
+    size_t skip(size_t position) const;
+};
+
+/**
+ * @brief A cursor to a value of a LazyDocument.
+ *
+ * Mirrors the read-only interface of JsonValue, reading from the input as
+ * needed. Cursors are cheap to copy and valid while their document lives at
+ * the same address.
+ */
+class LazyValue {
+  public:
+    /**
+     * @brief Retrieves the kind of value at the cursor.
+     */
+    JsonType type() const;
+
+    bool is_null() const {
+        return first_byte() == 'n';
+    }
+
+    bool is_bool() const {
+        return first_byte() == 't' || first_byte() == 'f';
+    }
+
+    bool is_number() const {
+        char c = first_byte();
+        return c == '-' || (c >= '0' && c <= '9');
+    }
+
+    bool is_string() const {
+        return first_byte() == '"';
+    }
+
+    bool is_object() const {
+        return first_byte() == '{';
+    }
+
+    bool is_array() const {
+        return first_byte() == '[';
+    }
+
+    /**
+     * @brief Reads the value at the cursor, including all its contents.
+     *
+     * @return The materialized value, or a ParseError if it is malformed
+     */
+    Result<JsonValue, ParseError> get() const;
+
+    /**
+     * @brief Reads the value as a string.
+     *
+     * @pre The value must be a well-formed string
+     * @throws Asserts in debug build the value must be a string.
+     */
+    operator std::string() const;
+
+    /**
+     * @brief Reads the value as a number.
+     *
+     * @pre The value must be a well-formed number
+     * @throws Asserts in debug build the value must be a number.
+     */
+    operator int() const {
+        return static_cast<int>(get_scalar());
+    }
+
+    operator double() const {
+        return static_cast<double>(get_scalar());
+    }
+
+    operator size_t() const {
+        return static_cast<size_t>(get_scalar());
+    }
+
+    int64_t to_int64() const {
+        return get_scalar().to_int64();
+    }
+
+    uint64_t to_uint64() const {
+        return get_scalar().to_uint64();
+    }
+
+    double to_double() const {
+        return get_scalar().to_double();
+    }
+
+    /**
+     * @brief Reads the value as a bool.
+     *
+     * @pre The value must be a boolean
+     * @throws Asserts in debug build the value must be a bool.
+     */
+    operator bool() const {
+        return static_cast<bool>(get_scalar());
+    }
+
+    /**
+     * @brief Counts the members of an object or the elements of an array.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Checks if an object has a member with the given key.
+     */
+    bool contains(std::string_view key) const;
+
+    /**
+     * @brief Moves the cursor to an object's member.
+     *
+     * @pre The value must be an object
+     * @throws std::out_of_range if there is no such member
+     */
+    LazyValue operator[](std::string_view key) const;
+
+    LazyValue operator[](const char* key) const {
+        return operator[](std::string_view(key));
+    }
+
+    LazyValue operator[](const std::string& key) const {
+        return operator[](std::string_view(key));
+    }
+
+    /**
+     * @brief Moves the cursor to an array's element.
+     *
+     * @pre The value must be an array
+     * @throws std::out_of_range if the index is out of bounds
+     */
+    LazyValue operator[](size_t index) const;
+
+    /**
+     * @brief Moves the cursor along a compiled JSON Pointer.
+     *
+     * Only the containers on the way are visited, the values before the
+     * ones looked up are jumped over.
+     *
+     * @param path The path to follow from this value, see brace/path.h
+     * @return The cursor, or nothing if the path leads nowhere
+     */
+    std::optional<LazyValue> find(const Path& path) const;
+
+  private:
+    friend class LazyDocument;
+
+    const LazyDocument* m_document;
+    size_t m_position;
+
+    LazyValue(const LazyDocument* document, size_t position) :
+        m_document(document),
+        m_position(position) {}
+
+    char first_byte() const {
+        return m_document->first_byte(m_position);
+    }
+
+    // Position of the member value with this key, 0 if there is none. The
+    // value of a member can never be at position 0.
+    size_t find_member(std::string_view key) const;
+    // Position of the element at this index, 0 if there is none
+    size_t find_element(size_t index) const;
+
+    JsonValue get_scalar() const;
+};
+
+}  // namespace brace
+
+#endif
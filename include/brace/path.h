@@ -0,0 +1,74 @@
+#ifndef __BRACE_PATH_H__
+#define __BRACE_PATH_H__
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "brace.h"
+
+namespace brace {
+
+/**
+ * @brief A JSON Pointer (RFC 6901) compiled for repeated lookups.
+ *
+ * Compiling splits the pointer into its reference tokens, decodes their
+ * escapes, and works out up front the hash each token is looked up by in
+ * large objects and the array index it stands for. Evaluating a path
+ * against many documents then only compares keys and follows indices.
+ *
+ * Paths are evaluated by JsonValue::find() and LazyValue::find(), and
+ * Parser::parse_paths() extracts them from input without parsing more of it
+ * than it takes.
+ *
+ * @code
+ * auto path = brace::Path::compile("/data/items/3/id").expect("pointer");
+ * const brace::JsonValue* id = document.root().find(path);
+ * @endcode
+ */
+class Path {
+  public:
+    /**
+     * @brief A reference token of the pointer.
+     */
+    struct Step {
+        // The token with `~0` and `~1` decoded
+        std::string key;
+        // std::hash<std::string_view> of the key
+        size_t hash;
+        // The array index the token stands for, npos if it is not one
+        size_t index;
+    };
+
+    static constexpr size_t npos = SIZE_MAX;
+
+    /**
+     * @brief An empty path, referring to the root value.
+     */
+    Path() = default;
+
+    /**
+     * @brief Compiles a JSON Pointer such as `/data/items/3/id`.
+     *
+     * @param pointer The pointer, empty for the root value
+     * @return The compiled Path, or a ParseError located within the
+     *         pointer if it is malformed
+     */
+    static Result<Path, ParseError> compile(std::string_view pointer);
+
+    const std::vector<Step>& steps() const {
+        return m_steps;
+    }
+
+    size_t size() const {
+        return m_steps.size();
+    }
+
+  private:
+    std::vector<Step> m_steps;
+};
+
+}  // namespace brace
+
+#endif
@@ -3,8 +3,10 @@
 
 #include <assert.h>
 
-#include <iostream>
+#include <cstdio>
+#include <cstdlib>
 #include <stdexcept>
+#include <string_view>
 #include <type_traits>
 #include <variant>
 
@@ -33,38 +35,26 @@ class [[nodiscard]] Result {
         return std::holds_alternative<E>(m_data);
     }
 
-    const T& expect(const std::string& message) const& {
-        if (is_ok()) {
-            return unwrap();
+    const T& expect(std::string_view message) const& {
+        if (!is_ok()) {
+            fail(message);
         }
-        std::cout << message << ": " << unwrap_err().message() << "\n";
-        std::abort();
+        return *std::get_if<T>(&m_data);
     }
 
-    T&& expect(const std::string& message) && {
-        if (is_ok()) {
-            return std::move(*this).unwrap();
+    T&& expect(std::string_view message) && {
+        if (!is_ok()) {
+            fail(message);
         }
-        std::cout << message << ": " << unwrap_err().message() << "\n";
-        std::abort();
+        return std::move(*std::get_if<T>(&m_data));
     }
 
     const T& unwrap() const& {
-        if (!is_ok()) {
-            std::cout << "Called unwrap on an Err value:"
-                      << unwrap_err().message() << "\n";
-            std::abort();
-        }
-        return std::get<T>(m_data);
+        return expect("Called unwrap on an Err value");
     }
 
     T&& unwrap() && {
-        if (!is_ok()) {
-            std::cout << "Called unwrap on an Err value:"
-                      << unwrap_err().message() << "\n";
-            std::abort();
-        }
-        return std::move(std::get<T>(m_data));
+        return std::move(*this).expect("Called unwrap on an Err value");
     }
 
     const T& unwrap_ok() const& {
@@ -77,61 +67,136 @@ class [[nodiscard]] Result {
 
     const E& unwrap_err() const& {
         assert(is_err() && "Called unwrap_err on an Ok value");
-        return std::get<E>(m_data);
+        return *std::get_if<E>(&m_data);
     }
 
     E&& unwrap_err() && {
         assert(is_err() && "Called unwrap_err on an Ok value");
-        return std::move(std::get<E>(m_data));
+        return std::move(*std::get_if<E>(&m_data));
     }
 
     template<typename F>
-    auto map(F&& f) const -> Result<decltype(f(std::declval<T>())), E> {
+    auto map(F&& f) const& -> Result<decltype(f(std::declval<const T&>())), E> {
         if (is_ok()) {
-            return Result<decltype(f(std::declval<T>())), E>(f(unwrap()));
+            return Result<decltype(f(std::declval<const T&>())), E>(f(unwrap()));
         }
-        return Result<decltype(f(std::declval<T>())), E>(unwrap_err());
+        return Result<decltype(f(std::declval<const T&>())), E>(unwrap_err());
     }
 
     template<typename F>
-    auto map_err(F&& f) const -> Result<T, decltype(f(std::declval<E>()))> {
+    auto map(F&& f) && -> Result<decltype(f(std::declval<T&&>())), E> {
+        if (is_ok()) {
+            return Result<decltype(f(std::declval<T&&>())), E>(
+                f(std::move(*this).unwrap())
+            );
+        }
+        return Result<decltype(f(std::declval<T&&>())), E>(
+            std::move(*this).unwrap_err()
+        );
+    }
+
+    template<typename F>
+    auto map_err(F&& f) const& -> Result<T, decltype(f(std::declval<const E&>()))> {
         if (is_err()) {
-            return Result<T, decltype(f(std::declval<E>()))>(f(unwrap_err()));
+            return Result<T, decltype(f(std::declval<const E&>()))>(f(unwrap_err()));
         }
-        return Result<T, decltype(f(std::declval<E>()))>(unwrap());
+        return Result<T, decltype(f(std::declval<const E&>()))>(unwrap());
     }
 
     template<typename F>
-    auto and_then(F&& f) const {
-        if (is_ok()) {
-            if constexpr (is_result<decltype(f(std::declval<T>()))>::value) {
+    auto map_err(F&& f) && -> Result<T, decltype(f(std::declval<E&&>()))> {
+        if (is_err()) {
+            return Result<T, decltype(f(std::declval<E&&>()))>(
+                f(std::move(*this).unwrap_err())
+            );
+        }
+        return Result<T, decltype(f(std::declval<E&&>()))>(
+            std::move(*this).unwrap()
+        );
+    }
+
+    template<typename F>
+    auto and_then(F&& f) const& {
+        using U = decltype(f(std::declval<const T&>()));
+        if constexpr (is_result<U>::value) {
+            if (is_ok()) {
                 return f(unwrap());
-            } else {
-                return Result<decltype(f(std::declval<T>())), E>(f(unwrap()));
             }
+            return U(unwrap_err());
+        } else {
+            if (is_ok()) {
+                return Result<U, E>(f(unwrap()));
+            }
+            return Result<U, E>(unwrap_err());
+        }
+    }
+
+    template<typename F>
+    auto and_then(F&& f) && {
+        using U = decltype(f(std::declval<T&&>()));
+        if constexpr (is_result<U>::value) {
+            if (is_ok()) {
+                return f(std::move(*this).unwrap());
+            }
+            return U(std::move(*this).unwrap_err());
+        } else {
+            if (is_ok()) {
+                return Result<U, E>(f(std::move(*this).unwrap()));
+            }
+            return Result<U, E>(std::move(*this).unwrap_err());
         }
-        return Result<decltype(f(std::declval<T>())), E>(unwrap_err());
     }
 
     template<typename U>
-    T unwrap_or(U&& default_value) const {
+    T unwrap_or(U&& default_value) const& {
         if (is_ok()) {
             return unwrap();
         }
         return static_cast<T>(std::forward<U>(default_value));
     }
 
+    template<typename U>
+    T unwrap_or(U&& default_value) && {
+        if (is_ok()) {
+            return std::move(*this).unwrap();
+        }
+        return static_cast<T>(std::forward<U>(default_value));
+    }
+
     template<typename F>
-    T unwrap_or_else(F&& f) const {
+    T unwrap_or_else(F&& f) const& {
         if (is_ok()) {
             return unwrap();
         }
         return f(unwrap_err());
     }
 
+    template<typename F>
+    T unwrap_or_else(F&& f) && {
+        if (is_ok()) {
+            return std::move(*this).unwrap();
+        }
+        return f(std::move(*this).unwrap_err());
+    }
+
   private:
     std::variant<T, E> m_data;
 
+    // Reports the error on stderr, formatting it only now, and aborts
+    [[noreturn]] void fail(std::string_view message) const {
+        const auto& formatted = unwrap_err().message();
+        std::string_view error(formatted);
+        std::fprintf(
+            stderr,
+            "%.*s: %.*s\n",
+            static_cast<int>(message.size()),
+            message.data(),
+            static_cast<int>(error.size()),
+            error.data()
+        );
+        std::abort();
+    }
+
     struct ok_tag {};
 
     struct err_tag {};
@@ -174,8 +239,8 @@ Result<T, E> Err(E&& error) {
         ({ \
             auto _result = (expr); \
             if (!_result.is_ok()) \
-                return _result.unwrap_err(); \
-            _result.unwrap(); \
+                return std::move(_result).unwrap_err(); \
+            std::move(_result).unwrap(); \
         })
 #endif
 
@@ -184,7 +249,7 @@ Result<T, E> Err(E&& error) {
         auto var##_result = (expr); \
         if (!var##_result.is_ok()) \
             return std::move(var##_result).unwrap_err(); \
-        auto var = var##_result.unwrap();
+        auto var = std::move(var##_result).unwrap();
 #endif
 #ifndef TRY_ASSIGN_MOVE
     #define TRY_ASSIGN_MOVE(var, expr) \
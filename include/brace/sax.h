@@ -0,0 +1,322 @@
+#ifndef __BRACE_SAX_H__
+#define __BRACE_SAX_H__
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "../priv/brace/stats.h"
+#include "brace.h"
+
+namespace brace {
+
+/**
+ * @brief Base for event handlers passed to Parser::parse_sax().
+ *
+ * Handlers derive from `SaxHandler<Handler>` and hide the events they are
+ * interested in, the others are ignored. Events are dispatched statically,
+ * so a handler's member functions can be inlined into the parser.
+ *
+ * Every event returns whether parsing should go on, returning false stops
+ * it with an error. String views passed to events are only valid until the
+ * event returns.
+ *
+ * Integers arrive through on_int64() or on_uint64() when they fit in 64
+ * bits and other numbers through on_double(). All three default to
+ * on_number(), which handlers can hide instead to receive every number as a
+ * double.
+ */
+template<typename Derived>
+class SaxHandler {
+  public:
+    bool on_null() {
+        return true;
+    }
+
+    bool on_bool(bool) {
+        return true;
+    }
+
+    bool on_int64(int64_t n) {
+        return derived().on_number(static_cast<double>(n));
+    }
+
+    bool on_uint64(uint64_t n) {
+        return derived().on_number(static_cast<double>(n));
+    }
+
+    bool on_double(double n) {
+        return derived().on_number(n);
+    }
+
+    bool on_number(double) {
+        return true;
+    }
+
+    bool on_string(std::string_view) {
+        return true;
+    }
+
+    bool on_key(std::string_view) {
+        return true;
+    }
+
+    bool on_start_object() {
+        return true;
+    }
+
+    /**
+     * @param members The number of members of the object
+     */
+    bool on_end_object(size_t) {
+        return true;
+    }
+
+    bool on_start_array() {
+        return true;
+    }
+
+    /**
+     * @param elements The number of elements of the array
+     */
+    bool on_end_array(size_t) {
+        return true;
+    }
+
+  private:
+    Derived& derived() {
+        return static_cast<Derived&>(*this);
+    }
+};
+
+}  // namespace brace
+
+namespace priv::brace {
+
+/**
+ * Walks the token stream of a Parser and reports it to a handler. This is
+ * the grammar of the parser, the DOM is built by one such handler.
+ *
+ * Nesting is followed with an explicit stack of the open containers, kept
+ * by the parser between runs, rather than by recursing. Deep input takes
+ * no more native stack than a flat one, and is rejected once it goes past
+ * the parser's maximum depth.
+ */
+template<typename Handler>
+class SaxDriver {
+  public:
+    /**
+     * @param depth How many containers the values read are already nested
+     *        in, which count towards the maximum depth
+     */
+    SaxDriver(::brace::Parser& parser, Handler& handler, size_t depth = 0) :
+        m_parser(parser),
+        m_handler(handler),
+        m_depth(depth) {}
+
+    ::brace::Result<::brace::Unit, ::brace::ParseError> parse_value();
+
+  private:
+    template<typename T, typename E>
+    using Result = ::brace::Result<T, E>;
+    using ParseError = ::brace::ParseError;
+    using ErrorCode = ::brace::ErrorCode;
+    using Unit = ::brace::Unit;
+
+    ::brace::Parser& m_parser;
+    Handler& m_handler;
+    size_t m_depth;
+
+    // Reads a scalar starting at the lookahead token
+    Result<Unit, ParseError> parse_scalar();
+    // Reads a member's key and the ':' after it
+    Result<Unit, ParseError> parse_key();
+
+    ParseError cancelled_at(const Token& token) const {
+        return m_parser.error_at(token, ErrorCode::Cancelled);
+    }
+};
+
+template<typename Handler>
+auto SaxDriver<Handler>::parse_value() -> Result<Unit, ParseError> {
+    std::vector<SaxFrame>& stack = m_parser.m_frame_stack;
+    stack.clear();  // Left over from a run that failed
+
+    while (true) {
+        // A value starts at the lookahead token
+        const Token token = m_parser.peek();
+        bool completed = true;
+        if (token.type == TokenType::LeftBrace
+            || token.type == TokenType::LeftBracket) {
+            bool is_object = token.type == TokenType::LeftBrace;
+            if (m_depth + stack.size() >= m_parser.m_max_depth) {
+                return m_parser.error_at(token, ErrorCode::DepthExceeded);
+            }
+            TRY(m_parser.advance());  // Consume '{' or '['
+            if (is_object ? !m_handler.on_start_object()
+                          : !m_handler.on_start_array()) {
+                return cancelled_at(token);
+            }
+            stack.push_back(SaxFrame {0, is_object});
+            if constexpr (::brace::ParseStats::enabled) {
+                size_t& deepest = m_parser.m_stats.max_depth;
+                deepest = std::max(deepest, m_depth + stack.size());
+            }
+
+            TokenType close =
+                is_object ? TokenType::RightBrace : TokenType::RightBracket;
+            if (m_parser.peek().type != close) {
+                if (is_object) {
+                    TRY(parse_key());
+                }
+                continue;
+            }
+            completed = false;  // Empty, closed right away
+        } else {
+            TRY(parse_scalar());
+        }
+
+        // Close every container the value was the last one of
+        while (!stack.empty()) {
+            SaxFrame& frame = stack.back();
+            TokenType close =
+                frame.is_object ? TokenType::RightBrace : TokenType::RightBracket;
+            if (completed) {
+                frame.count++;
+                const Token& next = m_parser.peek();
+                if (next.type == TokenType::Comma) {
+                    TRY(m_parser.advance());  // Consume ','
+                    if (m_parser.peek().type != close) {
+                        if (frame.is_object) {
+                            TRY(parse_key());
+                        }
+                        break;  // On to the next value
+                    }
+                } else if (next.type != close) {
+                    return m_parser.error_at(
+                        next,
+                        frame.is_object ? ErrorCode::ExpectedCommaOrBrace
+                                        : ErrorCode::ExpectedCommaOrBracket
+                    );
+                }
+            }
+
+            TRY_ASSIGN(closing, m_parser.advance());  // Consume '}' or ']'
+            SaxFrame closed = frame;
+            stack.pop_back();
+            bool proceed;
+            {
+                PhaseTimer timer(m_parser.m_stats.container_time);
+                proceed = closed.is_object
+                    ? m_handler.on_end_object(closed.count)
+                    : m_handler.on_end_array(closed.count);
+            }
+            if (!proceed) {
+                return cancelled_at(closing);
+            }
+            completed = true;
+        }
+        if (stack.empty()) {
+            return Unit {};
+        }
+    }
+}
+
+template<typename Handler>
+auto SaxDriver<Handler>::parse_scalar() -> Result<Unit, ParseError> {
+    const Token token = m_parser.peek();
+    bool proceed;
+
+    if (token.type == TokenType::StringLiteral) {
+        TRY(m_parser.advance());
+        proceed = m_handler.on_string(m_parser.decode_string(token));
+    } else if (token.type == TokenType::NumberLiteral) {
+        TRY(m_parser.advance());
+        Number number;
+        bool parsed;
+        {
+            PhaseTimer timer(m_parser.m_stats.number_time);
+            parsed = parse_number(token, number);
+        }
+        if (!parsed) {
+            return m_parser.error_at(
+                token,
+                ErrorCode::NumberOutOfRange,
+                token.lexeme
+            );
+        }
+        switch (number.kind) {
+            case NumberKind::Int64:
+                proceed = m_handler.on_int64(number.int64);
+                break;
+            case NumberKind::Uint64:
+                proceed = m_handler.on_uint64(number.uint64);
+                break;
+            default: proceed = m_handler.on_double(number.number); break;
+        }
+    } else if (token.type == TokenType::Keyword && token.lexeme == "null") {
+        TRY(m_parser.advance());
+        proceed = m_handler.on_null();
+    } else if (token.type == TokenType::Keyword
+               && (token.lexeme == "true" || token.lexeme == "false")) {
+        TRY(m_parser.advance());
+        proceed = m_handler.on_bool(token.lexeme == "true");
+    } else if (token.type == TokenType::Eof) {
+        return m_parser.error_at(token, ErrorCode::UnexpectedEnd);
+    } else {
+        return m_parser.error_at(token, ErrorCode::UnexpectedToken, token.lexeme);
+    }
+
+    if (!proceed) {
+        return cancelled_at(token);
+    }
+    return Unit {};
+}
+
+template<typename Handler>
+auto SaxDriver<Handler>::parse_key() -> Result<Unit, ParseError> {
+    TRY_ASSIGN(key, m_parser.advance());
+    if (key.type != TokenType::StringLiteral) {
+        return m_parser.error_at(key, ErrorCode::ExpectedKey);
+    }
+    if (!m_handler.on_key(m_parser.decode_string(key))) {
+        return cancelled_at(key);
+    }
+
+    TRY_ASSIGN(colon, m_parser.advance());
+    if (colon.type != TokenType::Colon) {
+        return m_parser.error_at(colon, ErrorCode::ExpectedColon);
+    }
+    return Unit {};
+}
+
+}  // namespace priv::brace
+
+namespace brace {
+
+template<typename Handler>
+Result<Unit, ParseError>
+Parser::parse_sax(std::string_view json, Handler& handler) {
+    return run_sax(json, false, handler);
+}
+
+template<typename Handler>
+Result<Unit, ParseError>
+Parser::parse_sax(PaddedInput input, Handler& handler) {
+    return run_sax(input.view(), true, handler);
+}
+
+template<typename Handler>
+Result<Unit, ParseError>
+Parser::run_sax(std::string_view json, bool padded, Handler& handler) {
+    ::priv::brace::StatsScope scope(m_stats);
+    TRY(start(json, 0, padded));
+    ::priv::brace::SaxDriver<Handler> driver(*this, handler);
+    TRY(driver.parse_value());
+    return finish();
+}
+
+}  // namespace brace
+
+#endif
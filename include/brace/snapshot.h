@@ -0,0 +1,266 @@
+#ifndef __BRACE_SNAPSHOT_H__
+#define __BRACE_SNAPSHOT_H__
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "brace.h"
+
+namespace priv::brace {
+
+class MappedFile;
+
+}  // namespace priv::brace
+
+namespace brace {
+
+class Path;
+class SnapshotValue;
+
+/**
+ * @brief A parsed value saved in a binary form that is read in place.
+ *
+ * Snapshots lay values out one after the other in a flat buffer, in the
+ * order they appear, and refer to the contents of arrays and objects by
+ * their offset rather than a pointer. Equal keys, strings and numbers are
+ * stored once, and small integers in place of an offset. A snapshot mapped
+ * from a file is therefore queried right away, without deserializing it,
+ * and startup only pays for the pages that are looked at. Objects larger
+ * than JsonObject::index_threshold keep their members sorted by key as
+ * well, so members are found by binary search.
+ *
+ * Snapshots are meant to be read back by the program that wrote them: they
+ * are in the byte order of the machine. Only their header and size are
+ * checked when opened, the rest as it is read, so that the parts of a
+ * damaged snapshot that do not fit in it read as null or empty.
+ *
+ * @code
+ * brace::Snapshot::write(config, "config.snapshot").expect("write");
+ * auto snapshot = brace::Snapshot::open("config.snapshot").expect("open");
+ * std::string_view level = snapshot.root()["log"]["level"].to_string_view();
+ * @endcode
+ */
+class Snapshot {
+  public:
+    Snapshot(Snapshot&&) noexcept;
+    Snapshot& operator=(Snapshot&&) noexcept;
+    ~Snapshot();
+
+    /**
+     * @brief Encodes `value` as a snapshot.
+     *
+     * @return The snapshot's bytes, or a ParseError with
+     *         ErrorCode::InputTooLarge if it would exceed 16 GiB
+     */
+    static Result<std::string, ParseError> encode(const JsonValue& value);
+
+    /**
+     * @brief Encodes `value` as a snapshot and saves it to `path`.
+     *
+     * @return Unit on success, a ParseError without a location otherwise
+     */
+    static Result<Unit, ParseError>
+    write(const JsonValue& value, const std::string& path);
+
+    /**
+     * @brief Maps the snapshot saved at `path` into memory.
+     *
+     * @return The Snapshot, or a ParseError with ErrorCode::InvalidSnapshot
+     *         if the file is not a snapshot of this version and byte order
+     */
+    static Result<Snapshot, ParseError> open(const std::string& path);
+
+    /**
+     * @brief Reads a snapshot from bytes that are already in memory.
+     *
+     * @param bytes The output of encode(), which must outlive the result
+     */
+    static Result<Snapshot, ParseError> view(std::string_view bytes);
+
+    /**
+     * @brief Retrieves a cursor to the value the snapshot was made of.
+     */
+    SnapshotValue root() const;
+
+    std::string_view bytes() const {
+        return m_bytes;
+    }
+
+  private:
+    // Holds the bytes of an opened snapshot
+    std::unique_ptr<::priv::brace::MappedFile> m_file;
+    std::string_view m_bytes;
+    // Where to find the root value, see src/snapshot.cpp
+    uint32_t m_root {0};
+
+    Snapshot() = default;
+
+    static Result<Snapshot, ParseError> check(Snapshot&& snapshot);
+};
+
+/**
+ * @brief A cursor to a value of a Snapshot.
+ *
+ * Mirrors the read-only interface of JsonValue and LazyValue, reading
+ * straight from the snapshot's bytes. Strings are viewed where they are
+ * stored. Cursors are cheap to copy and stay valid while their snapshot
+ * lives, even if it is moved.
+ */
+class SnapshotValue {
+  public:
+    /**
+     * @brief Retrieves the kind of value at the cursor.
+     */
+    JsonType type() const;
+
+    bool is_null() const {
+        return type() == JsonType::Null;
+    }
+
+    bool is_bool() const {
+        return type() == JsonType::Bool;
+    }
+
+    bool is_number() const {
+        JsonType t = type();
+        return t == JsonType::Int64 || t == JsonType::Uint64
+            || t == JsonType::Double;
+    }
+
+    bool is_string() const {
+        return type() == JsonType::String;
+    }
+
+    bool is_object() const {
+        return type() == JsonType::Object;
+    }
+
+    bool is_array() const {
+        return type() == JsonType::Array;
+    }
+
+    /**
+     * @brief Copies the value at the cursor, including all its contents.
+     */
+    JsonValue get() const;
+
+    /**
+     * @brief Views the value as a string, within the snapshot.
+     *
+     * @pre The value must be a string
+     * @throws Asserts in debug build the value must be a string.
+     */
+    std::string_view to_string_view() const;
+
+    operator std::string() const {
+        return std::string(to_string_view());
+    }
+
+    /**
+     * @brief Reads the value as a number.
+     *
+     * @pre The value must be a number
+     * @throws Asserts in debug build the value must be a number.
+     */
+    operator int() const {
+        return static_cast<int>(get_scalar());
+    }
+
+    operator double() const {
+        return static_cast<double>(get_scalar());
+    }
+
+    operator size_t() const {
+        return static_cast<size_t>(get_scalar());
+    }
+
+    int64_t to_int64() const {
+        return get_scalar().to_int64();
+    }
+
+    uint64_t to_uint64() const {
+        return get_scalar().to_uint64();
+    }
+
+    double to_double() const {
+        return get_scalar().to_double();
+    }
+
+    /**
+     * @brief Reads the value as a bool.
+     *
+     * @pre The value must be a boolean
+     * @throws Asserts in debug build the value must be a bool.
+     */
+    operator bool() const {
+        return static_cast<bool>(get_scalar());
+    }
+
+    /**
+     * @brief Counts the members of an object or the elements of an array.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Checks if an object has a member with the given key.
+     */
+    bool contains(std::string_view key) const;
+
+    /**
+     * @brief Moves the cursor to an object's member.
+     *
+     * @pre The value must be an object
+     * @throws std::out_of_range if there is no such member
+     */
+    SnapshotValue operator[](std::string_view key) const;
+
+    SnapshotValue operator[](const char* key) const {
+        return operator[](std::string_view(key));
+    }
+
+    SnapshotValue operator[](const std::string& key) const {
+        return operator[](std::string_view(key));
+    }
+
+    /**
+     * @brief Moves the cursor to an array's element.
+     *
+     * @pre The value must be an array
+     * @throws std::out_of_range if the index is out of bounds
+     */
+    SnapshotValue operator[](size_t index) const;
+
+    /**
+     * @brief Moves the cursor along a compiled JSON Pointer.
+     *
+     * @param path The path to follow from this value, see brace/path.h
+     * @return The cursor, or nothing if the path leads nowhere
+     */
+    std::optional<SnapshotValue> find(const Path& path) const;
+
+  private:
+    friend class Snapshot;
+
+    std::string_view m_bytes;
+    // Offset of the value in words, or the value of a small integer
+    uint32_t m_slot;
+
+    SnapshotValue(std::string_view bytes, uint32_t slot) :
+        m_bytes(bytes),
+        m_slot(slot) {}
+
+    uint64_t head() const;
+    // Slot of the member value with this key, 0 if there is none. No value
+    // is stored at offset 0, where the header is.
+    uint32_t find_member(std::string_view key) const;
+    JsonValue get_scalar() const;
+    // get() of a value nested `depth` containers deep
+    JsonValue materialize(size_t depth) const;
+};
+
+}  // namespace brace
+
+#endif
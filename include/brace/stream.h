@@ -0,0 +1,150 @@
+#ifndef __BRACE_STREAM_H__
+#define __BRACE_STREAM_H__
+
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "brace.h"
+
+namespace priv::brace {
+class DomBuilder;
+}
+
+namespace brace {
+
+/**
+ * @brief A parser for input that arrives in chunks.
+ *
+ * Chunks are handed to feed() as they are received, from a socket or a
+ * pipe for example, and the value is returned by finish() once the input
+ * has ended. Each chunk is parsed as far as it goes when it is fed, only
+ * the bytes of a token cut off at its end are kept for the next one, so
+ * the whole input is never buffered.
+ *
+ * Errors are reported by the feed() or finish() call that finds them,
+ * once a parser has failed every further call reports the same error until
+ * it is reset().
+ */
+class StreamParser {
+  public:
+    /**
+     * @brief Creates a parser ready for the first chunk of a value.
+     *
+     * @param resource The resource parsed values are allocated from
+     */
+    explicit StreamParser(
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    ) :
+        m_resource(resource) {}
+
+    /**
+     * @brief Parses the next chunk of input.
+     *
+     * @return Unit on success, a ParseError if the input so far is malformed
+     */
+    Result<Unit, ParseError> feed(const char* data, size_t size);
+
+    Result<Unit, ParseError> feed(std::string_view chunk) {
+        return feed(chunk.data(), chunk.size());
+    }
+
+    /**
+     * @brief Ends the input and retrieves the parsed value.
+     *
+     * The parser is reset afterwards, ready for the next value.
+     *
+     * @return The parsed JsonValue on success, a ParseError if the input is
+     *         malformed or incomplete
+     */
+    Result<JsonValue, ParseError> finish();
+
+    /**
+     * @brief Discards any input fed so far, keeping allocated buffers.
+     */
+    void reset();
+
+    /**
+     * @brief Sets how deeply arrays and objects may nest, like
+     *        Parser::set_max_depth() does.
+     */
+    void set_max_depth(size_t depth) {
+        m_max_depth = depth;
+    }
+
+  private:
+    // What the next token must be
+    enum class Expect : uint8_t {
+        Value,
+        ValueOrClose,  // After '['
+        Key,
+        KeyOrClose,  // After '{'
+        Colon,
+        CommaOrClose,
+        Done,  // The root value has ended, anything after it is ignored
+    };
+
+    std::pmr::memory_resource* m_resource;
+    size_t m_max_depth {default_max_depth};
+    ::priv::brace::Tokenizer m_tokenizer;
+    // Input not consumed yet, starting right after the last complete token
+    std::string m_buffer;
+    // Location of the first byte of m_buffer in the whole input
+    size_t m_offset {0};
+    size_t m_line {1};
+    size_t m_column {1};
+    Expect m_expect {Expect::Value};
+    // Whether m_buffer ends in the middle of a string literal
+    bool m_in_string {false};
+    // How far that string has been searched for its closing quote, and
+    // whether the search stopped right after a backslash
+    size_t m_string_scanned {0};
+    bool m_string_escape {false};
+    std::optional<ParseError> m_error;
+    JsonValue m_root;
+    // Decoded contents of the last string literal with escapes
+    std::string m_scratch;
+    // Members and elements of the objects and arrays being parsed
+    std::vector<JsonObject::value_type> m_member_stack;
+    std::vector<JsonValue> m_element_stack;
+    // For each container being built, whether it is an object, and how
+    // many values it has so far
+    std::vector<bool> m_container_stack;
+    std::vector<size_t> m_count_stack;
+
+    // Parses the complete tokens of m_buffer, or all of it if `final`
+    Result<Unit, ParseError> consume(bool final);
+    Result<Unit, ParseError>
+    process(const ::priv::brace::Token& token, ::priv::brace::DomBuilder& builder);
+    Result<Unit, ParseError>
+    value(const ::priv::brace::Token& token, ::priv::brace::DomBuilder& builder);
+    void close(::priv::brace::DomBuilder& builder);
+    void end_value(::priv::brace::DomBuilder& builder);
+    // Searches the rest of a pending string for where it could end,
+    // carrying on from where the last search stopped
+    bool scan_string();
+    // Drops the first `size` bytes of m_buffer
+    void discard(size_t size);
+    std::string_view decode_string(const ::priv::brace::Token& token);
+
+    // Locates `offset` of m_buffer within the whole input
+    ParseError
+    error_at(size_t offset, ErrorCode code, std::string_view detail = {}) const {
+        auto location = ::priv::brace::locate(m_buffer, offset);
+        return ParseError(
+            code,
+            m_offset + offset,
+            m_line + location.line - 1,
+            location.line == 1 ? m_column + location.column - 1
+                               : location.column,
+            detail
+        );
+    }
+};
+
+}  // namespace brace
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef __BRACE_WRITER_H__
+#define __BRACE_WRITER_H__
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "brace.h"
+
+namespace brace {
+
+/**
+ * @brief Serializes JsonValues to JSON text.
+ *
+ * Output is appended to a buffer that is kept across writes, so a Writer
+ * reused for many values stops allocating once the buffer is large enough.
+ * A Writer constructed with a sink hands the buffer to it whenever it fills
+ * up and at the end of every write() instead of accumulating the output.
+ *
+ * Doubles are written in their shortest form that parses back to the same
+ * value, with a trailing ".0" if they would otherwise read as integers. NaN
+ * and infinities have no JSON representation and are written as null.
+ */
+class Writer {
+  public:
+    /**
+     * @brief Receives chunks of output from a Writer.
+     */
+    using Sink = std::function<void(std::string_view)>;
+
+    /**
+     * @brief Creates a writer that keeps its output in its buffer.
+     *
+     * @param indent Spaces per nesting level, 0 for compact output
+     */
+    explicit Writer(size_t indent = 0) : m_indent(indent) {}
+
+    /**
+     * @brief Creates a writer that passes its output on to `sink`.
+     *
+     * @param sink Called with each chunk of output, in order
+     * @param indent Spaces per nesting level, 0 for compact output
+     */
+    explicit Writer(Sink sink, size_t indent = 0) :
+        m_sink(std::move(sink)),
+        m_indent(indent) {}
+
+    /**
+     * @brief Serializes `value`, appending it to the output.
+     */
+    void write(const JsonValue& value);
+
+    /**
+     * @brief Retrieves the output buffered so far.
+     */
+    std::string_view output() const {
+        return m_buffer;
+    }
+
+    /**
+     * @brief Moves the buffered output out of the writer.
+     */
+    std::string take() {
+        return std::move(m_buffer);
+    }
+
+    /**
+     * @brief Discards the buffered output, keeping the buffer's capacity.
+     */
+    void clear() {
+        m_buffer.clear();
+    }
+
+  private:
+    std::string m_buffer;
+    Sink m_sink;
+    size_t m_indent;
+    size_t m_depth {0};
+
+    void write_value(const JsonValue& value);
+    void write_object(const JsonObject& object);
+    void write_array(const JsonArray& array);
+    void write_string(std::string_view text);
+    void write_double(double number);
+    void write_newline();
+    void flush_if_full();
+};
+
+}  // namespace brace
+
+#endif
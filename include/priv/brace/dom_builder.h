@@ -0,0 +1,162 @@
+#ifndef __PRIV_BRACE_DOM_BUILDER_H__
+#define __PRIV_BRACE_DOM_BUILDER_H__
+
+#include <brace/sax.h>
+#include <priv/brace/key_table.h>
+#include <priv/brace/stats.h>
+#include <priv/brace/string_table.h>
+
+#include <iterator>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+namespace priv::brace {
+
+using ::brace::JsonArray;
+using ::brace::JsonKey;
+using ::brace::JsonObject;
+using ::brace::JsonValue;
+
+// Builds the DOM from parse events. Members and elements are collected on
+// stacks shared by all nesting levels, so that each object and array can
+// be allocated at its final size once it ends. Keys and strings are interned
+// when given tables to intern them in, and values are built shared when
+// asked to.
+class DomBuilder: public ::brace::SaxHandler<DomBuilder> {
+  public:
+    DomBuilder(
+        std::pmr::memory_resource* resource,
+        std::vector<JsonObject::value_type>& members,
+        std::vector<JsonValue>& elements,
+        std::vector<bool>& containers,
+        KeyTable* keys = nullptr,
+        bool shared = false,
+        StringTable* strings = nullptr
+    ) :
+        m_resource(resource),
+        m_members(members),
+        m_elements(elements),
+        m_containers(containers),
+        m_keys(keys),
+        m_shared(shared),
+        m_strings(strings) {}
+
+    bool on_null() {
+        return add(JsonValue());
+    }
+
+    bool on_bool(bool b) {
+        return add(JsonValue(b));
+    }
+
+    bool on_int64(int64_t n) {
+        return add(JsonValue(n));
+    }
+
+    bool on_uint64(uint64_t n) {
+        return add(JsonValue(n));
+    }
+
+    bool on_double(double n) {
+        return add(JsonValue(n));
+    }
+
+    bool on_string(std::string_view s) {
+        if (m_strings) {
+            return add(m_strings->intern(s));
+        } else if (m_shared) {
+            return add(JsonValue::shared_string(s, m_resource));
+        }
+        return add(JsonValue(s, m_resource));
+    }
+
+    bool on_key(std::string_view key) {
+        // The value is filled in once it is complete
+        m_members.emplace_back(
+            m_keys ? m_keys->intern(key) : JsonKey(key, m_resource),
+            JsonValue()
+        );
+        return true;
+    }
+
+    bool on_start_object() {
+        m_containers.push_back(true);
+        return true;
+    }
+
+    bool on_end_object(size_t members) {
+        m_containers.pop_back();
+
+        JsonObject object(m_resource);
+        object.reserve(members);
+        if (members) {
+            count_allocation(members * sizeof(JsonObject::value_type));
+        }
+        size_t base = m_members.size() - members;
+        for (size_t i = base; i < m_members.size(); i++) {
+            auto& [key, value] = m_members[i];
+            object.insert_or_assign(std::move(key), std::move(value));
+        }
+        m_members.resize(base);
+        if (m_shared) {
+            return add(JsonValue::shared_object(std::move(object)));
+        }
+        return add(JsonValue(std::move(object)));
+    }
+
+    bool on_start_array() {
+        m_containers.push_back(false);
+        return true;
+    }
+
+    bool on_end_array(size_t elements) {
+        m_containers.pop_back();
+
+        JsonArray array(m_resource);
+        array.reserve(elements);
+        if (elements) {
+            count_allocation(elements * sizeof(JsonValue));
+        }
+        size_t base = m_elements.size() - elements;
+        std::move(
+            m_elements.begin() + base,
+            m_elements.end(),
+            std::back_inserter(array)
+        );
+        m_elements.resize(base);
+        if (m_shared) {
+            return add(JsonValue::shared_array(std::move(array)));
+        }
+        return add(JsonValue(std::move(array)));
+    }
+
+    JsonValue take_root() {
+        return std::move(m_root);
+    }
+
+  private:
+    std::pmr::memory_resource* m_resource;
+    std::vector<JsonObject::value_type>& m_members;
+    std::vector<JsonValue>& m_elements;
+    std::vector<bool>& m_containers;
+    KeyTable* m_keys;
+    bool m_shared;
+    StringTable* m_strings;
+    JsonValue m_root;
+
+    bool add(JsonValue&& value) {
+        if (m_containers.empty()) {
+            m_root = std::move(value);
+        } else if (m_containers.back()) {
+            m_members.back().second = std::move(value);
+        } else {
+            m_elements.push_back(std::move(value));
+        }
+        return true;
+    }
+};
+
+}  // namespace priv::brace
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef __PRIV_BRACE_KEY_TABLE_H__
+#define __PRIV_BRACE_KEY_TABLE_H__
+
+#include <brace/brace.h>
+
+#include <algorithm>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+namespace priv::brace {
+
+/**
+ * Interns the keys of a document. Every distinct key too long to be stored
+ * inline is stored once, with its hash, in a block all the JsonKeys equal
+ * to it share. Blocks come from the document's arena and are never freed
+ * on their own, the table is reset along with the arena.
+ */
+class KeyTable {
+  public:
+    using JsonKey = ::brace::JsonKey;
+
+    /**
+     * @param upstream The resource the table itself grows in, which it
+     *        keeps across resets
+     */
+    explicit KeyTable(std::pmr::memory_resource* upstream) : m_slots(upstream) {}
+
+    /**
+     * Forgets every key, blocks of new keys are allocated from `resource`
+     * from now on.
+     */
+    void reset(std::pmr::memory_resource* resource) {
+        m_resource = resource;
+        std::fill(m_slots.begin(), m_slots.end(), nullptr);
+        m_size = 0;
+    }
+
+    JsonKey intern(std::string_view key);
+
+  private:
+    std::pmr::memory_resource* m_resource {nullptr};
+    // Power-of-two sized, open-addressing table of blocks, at most half full
+    std::pmr::vector<const JsonKey::Rep*> m_slots;
+    size_t m_size {0};
+
+    void grow();
+};
+
+}  // namespace priv::brace
+
+#endif
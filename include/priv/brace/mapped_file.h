@@ -0,0 +1,48 @@
+#ifndef __PRIV_BRACE_MAPPED_FILE_H__
+#define __PRIV_BRACE_MAPPED_FILE_H__
+
+#include <brace/brace.h>
+
+#include <string>
+#include <string_view>
+
+namespace priv::brace {
+
+/**
+ * Read-only contents of a whole file. Regular files are mapped into memory
+ * so that they can be parsed without copying them, anything that can not
+ * be mapped, such as a pipe, is read into a buffer instead.
+ */
+class MappedFile {
+  public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Opens `path` and maps or reads all of it.
+     *
+     * @param sequential Whether the contents will be read front to back,
+     *        which has them read ahead, rather than looked up here and there
+     * @return Unit on success, a ParseError without a location otherwise
+     */
+    ::brace::Result<::brace::Unit, ::brace::ParseError>
+    open(const std::string& path, bool sequential = true);
+
+    std::string_view contents() const {
+        return std::string_view(m_data, m_size);
+    }
+
+  private:
+    const char* m_data {nullptr};
+    size_t m_size {0};
+    bool m_mapped {false};
+    // Contents of a file that could not be mapped
+    std::string m_buffer;
+};
+
+}  // namespace priv::brace
+
+#endif
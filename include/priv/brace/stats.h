@@ -0,0 +1,151 @@
+#ifndef __PRIV_BRACE_STATS_H__
+#define __PRIV_BRACE_STATS_H__
+
+#include <brace/brace.h>
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace priv::brace {
+
+using ::brace::ParseStats;
+
+// The stats allocations made on this thread are counted in, set while a
+// parse collecting stats runs. Parsed values allocate from resources that
+// outlive the parser, so they are counted where they allocate rather than
+// through a resource of the parser's.
+extern thread_local ParseStats* active_stats;
+
+// Counts an allocation made for a parsed value
+inline void count_allocation(size_t bytes) {
+    if constexpr (ParseStats::enabled) {
+        if (active_stats) {
+            active_stats->allocations++;
+            active_stats->allocated_bytes += bytes;
+        }
+    }
+}
+
+inline void count_token(ParseStats& stats, const Token& token) {
+    if constexpr (ParseStats::enabled) {
+        switch (token.type) {
+            case TokenType::Keyword: stats.keywords++; break;
+            case TokenType::NumberLiteral: stats.numbers++; break;
+            case TokenType::StringLiteral: stats.strings++; break;
+            case TokenType::LeftBrace:
+            case TokenType::RightBrace: stats.braces++; break;
+            case TokenType::LeftBracket:
+            case TokenType::RightBracket: stats.brackets++; break;
+            case TokenType::Colon: stats.colons++; break;
+            case TokenType::Comma: stats.commas++; break;
+            case TokenType::Punctuation: stats.punctuation++; break;
+            case TokenType::Eof: break;
+        }
+    }
+}
+
+// Picks which events of the phases are timed. Reading the clock takes
+// longer than scanning most tokens does, so a random one in about
+// `interval` events is timed and counted as if each of them took as long.
+// Random picks keep regular input from only ever sampling the same token.
+struct PhaseSampler {
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr uint32_t interval = 32;
+
+    uint32_t countdown {1};
+    uint32_t state {0x9e3779b9};
+    // What reading the clock adds to every time taken, measured once per
+    // thread and taken off them
+    std::optional<Clock::duration> overhead;
+
+    bool sample() {
+        if (--countdown != 0) {
+            return false;
+        }
+        // xorshift32, gaps average out to `interval`
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        countdown = 1 + state % (2 * interval - 1);
+        return true;
+    }
+
+    Clock::duration clock_overhead() {
+        if (!overhead) {
+            overhead = measure_overhead();
+        }
+        return *overhead;
+    }
+
+    static Clock::duration measure_overhead();
+};
+
+extern thread_local PhaseSampler phase_sampler;
+
+// Adds the time from its construction to its destruction to a phase, when
+// the sampler picks it
+class PhaseTimer {
+  public:
+    explicit PhaseTimer(std::chrono::nanoseconds& phase) : m_phase(phase) {
+        if constexpr (ParseStats::enabled) {
+            m_sampled = phase_sampler.sample();
+            if (m_sampled) {
+                m_start = PhaseSampler::Clock::now();
+            }
+        }
+    }
+
+    ~PhaseTimer() {
+        if constexpr (ParseStats::enabled) {
+            if (m_sampled) {
+                auto elapsed = PhaseSampler::Clock::now() - m_start
+                    - phase_sampler.clock_overhead();
+                if (elapsed.count() > 0) {
+                    m_phase += elapsed * PhaseSampler::interval;
+                }
+            }
+        }
+    }
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+  private:
+    std::chrono::nanoseconds& m_phase;
+    PhaseSampler::Clock::time_point m_start;
+    bool m_sampled {false};
+};
+
+// Collects the stats of a parse into `stats` for as long as it lives. They
+// are reset first, unless a scope collecting into the same stats is already
+// active on this thread: parses made by another parse add up.
+class StatsScope {
+  public:
+    explicit StatsScope(ParseStats& stats) {
+        if constexpr (ParseStats::enabled) {
+            m_outer = active_stats;
+            if (m_outer != &stats) {
+                stats = ParseStats();
+                active_stats = &stats;
+            }
+        }
+    }
+
+    ~StatsScope() {
+        if constexpr (ParseStats::enabled) {
+            active_stats = m_outer;
+        }
+    }
+
+    StatsScope(const StatsScope&) = delete;
+    StatsScope& operator=(const StatsScope&) = delete;
+
+  private:
+    ParseStats* m_outer {nullptr};
+};
+
+}  // namespace priv::brace
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef __PRIV_BRACE_STRING_TABLE_H__
+#define __PRIV_BRACE_STRING_TABLE_H__
+
+#include <brace/brace.h>
+
+#include <memory_resource>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace priv::brace {
+
+/**
+ * Interns the string values of a document, or the shared string values
+ * parsed by one call. Strings too long to be stored inline but short
+ * enough to be repeated, such as host names and status codes, are stored
+ * once and every equal value refers to that copy. The table is bounded,
+ * strings beyond the first `max_strings` distinct ones are stored on their
+ * own.
+ *
+ * A document's strings are blocks of its arena that no value owns, the
+ * table is reset along with the arena. Shared strings are reference
+ * counted like any shared value, the table holding one reference to each
+ * until it is reset.
+ */
+class StringTable {
+  public:
+    using JsonValue = ::brace::JsonValue;
+
+    // Longer strings seldom repeat and take longer to compare
+    static constexpr size_t max_string_size = 64;
+    static constexpr size_t max_strings = 4096;
+
+    /**
+     * @param upstream The resource the table itself grows in, which it
+     *        keeps across resets
+     */
+    explicit StringTable(std::pmr::memory_resource* upstream) : m_slots(upstream) {}
+
+    /**
+     * Forgets every string, the strings of new values are allocated from
+     * `resource` from now on. They are shared values if `shared` is set,
+     * blocks owned by no value otherwise.
+     */
+    void reset(std::pmr::memory_resource* resource, bool shared);
+
+    JsonValue intern(std::string_view s);
+
+  private:
+    // Free while the value is null
+    struct Slot {
+        size_t hash;
+        JsonValue value;
+    };
+
+    std::pmr::memory_resource* m_resource {nullptr};
+    bool m_shared {false};
+    // Power-of-two sized, open-addressing table, at most half full
+    std::pmr::vector<Slot> m_slots;
+    size_t m_size {0};
+
+    // A value with a copy of its own of `s`
+    JsonValue store(std::string_view s) const;
+    // A value referring to the interned string of `value`
+    JsonValue refer(const JsonValue& value) const;
+    void grow();
+};
+
+// Provides the table interning the shared strings of a parser's call for
+// as long as it lives. A table already installed in `current`, by a call
+// the parse is part of, is used as it is. Otherwise one is made and
+// installed, so that the parses the call makes share it.
+class StringScope {
+  public:
+    StringScope(
+        StringTable*& current,
+        std::pmr::memory_resource* resource,
+        bool active
+    ) {
+        if (!active) {
+            return;
+        }
+        if (!current) {
+            m_local.emplace(std::pmr::get_default_resource());
+            m_local->reset(resource, true);
+            current = &*m_local;
+            m_installed = &current;
+        }
+        m_table = current;
+    }
+
+    ~StringScope() {
+        if (m_installed) {
+            *m_installed = nullptr;
+        }
+    }
+
+    StringScope(const StringScope&) = delete;
+    StringScope& operator=(const StringScope&) = delete;
+
+    // Null unless strings are interned
+    StringTable* table() const {
+        return m_table;
+    }
+
+  private:
+    std::optional<StringTable> m_local;
+    StringTable** m_installed {nullptr};
+    StringTable* m_table {nullptr};
+};
+
+}  // namespace priv::brace
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef __PRIV_BRACE_STRUCTURAL_INDEX_H__
+#define __PRIV_BRACE_STRUCTURAL_INDEX_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+namespace priv::brace {
+
+/**
+ * First tokenizing stage: classifies the input 64 bytes at a time with the
+ * widest vector instructions the CPU supports and records the offset of
+ * every byte a token starts at. These are the structural characters, the
+ * opening quotes of strings and the first byte of keywords and numbers.
+ * Whitespace and string contents never appear in the index.
+ *
+ * Scanning is resumable, so the index can be built for a window of the
+ * input at a time. Comments can not be classified without a full lexer,
+ * so scanning stops as soon as one is found outside of a string.
+ */
+class StructuralIndexer {
+  public:
+    /**
+     * @brief Inputs at least this large can not be indexed, since offsets
+     *        are stored as 32-bit integers.
+     */
+    static constexpr size_t max_input_size = UINT32_MAX;
+
+    /**
+     * @brief Restarts scanning at `position` of a new input.
+     *
+     * The position must not be inside a string literal, so it is usually
+     * the start of the input or of a token.
+     *
+     * @param padded Whether a whole block past the end of the input can be
+     *        read, so that the last block is scanned in place
+     */
+    void reset(size_t position = 0, bool padded = false);
+
+    /**
+     * @brief Indexes the next window of `input`.
+     *
+     * Continues where the previous call stopped and scans at least
+     * `min_bytes` more, rounded up to whole blocks, or up to the end. The
+     * offsets found replace those of the previous window.
+     *
+     * @return false if a comment was found outside of a string. The window
+     *         is then incomplete and scanning must not continue.
+     */
+    bool scan(std::string_view input, size_t min_bytes);
+
+    /**
+     * @brief Indexes the whole input in one go.
+     *
+     * @return false if the input can not be indexed
+     */
+    bool scan_all(std::string_view input);
+
+    /**
+     * @brief Retrieves the token offsets of the current window, ascending.
+     */
+    const uint32_t* structurals() const {
+        return m_structurals.get();
+    }
+
+    /**
+     * @brief Retrieves the number of token offsets in the current window.
+     */
+    size_t size() const {
+        return m_size;
+    }
+
+    /**
+     * @brief Retrieves how many bytes of the input have been scanned.
+     */
+    size_t position() const {
+        return m_position;
+    }
+
+    /**
+     * @brief Retrieves the name of the vector instruction set in use.
+     */
+    static const char* implementation();
+
+  private:
+    // Left uninitialized, every scan writes before it reads. The capacity is
+    // kept across inputs.
+    std::unique_ptr<uint32_t[]> m_structurals;
+    size_t m_capacity {0};
+    size_t m_size {0};
+
+    size_t m_position {0};
+    bool m_padded {false};
+    uint64_t m_prev_escaped {0};
+    uint64_t m_prev_in_string {0};
+    uint64_t m_prev_scalar {0};
+
+    void reserve(size_t capacity);
+    // Only the first `valid` bytes of the block are part of the input
+    bool scan_block(const char* block, size_t offset, size_t valid);
+};
+
+/**
+ * @brief Finds the next byte a string literal scan has to stop at.
+ *
+ * Looks for a quote, a backslash or a line feed 16 bytes at a time,
+ * starting at `from`. Sets `non_ascii` if any byte before the one found
+ * has its high bit set. A `padded` input is followed by at least 16
+ * readable bytes, which lets the last bytes be searched the same way.
+ *
+ * @return The offset of the first such byte, or the input size if there
+ *         is none
+ */
+size_t find_string_delimiter(
+    std::string_view input,
+    size_t from,
+    bool& non_ascii,
+    bool padded = false
+);
+
+/**
+ * @brief Checks that `text` is well-formed UTF-8.
+ *
+ * Runs of ASCII are skipped 16 bytes at a time, multi-byte sequences are
+ * checked for overlong encodings, surrogates and code points past U+10FFFF.
+ */
+bool validate_utf8(std::string_view text);
+
+/**
+ * @brief Finds the next byte a JSON string has to escape when written.
+ *
+ * Looks for a quote, a backslash or a control character 16 bytes at a time,
+ * starting at `from`.
+ *
+ * @return The offset of the first such byte, or the text size if there is
+ *         none
+ */
+size_t find_escape_char(std::string_view text, size_t from);
+
+}  // namespace priv::brace
+
+#endif
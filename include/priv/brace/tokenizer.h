@@ -1,132 +1,247 @@
 #ifndef __PRIV_JONNY_TOKENIZER_H__
 #define __PRIV_JONNY_TOKENIZER_H__
 
+#include <brace/error.h>
 #include <brace/result.h>
+#include <priv/brace/structural_index.h>
 
-#include <sstream>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace priv::brace {
 
-enum class TokenType {
+enum class TokenType : uint8_t {
     Keyword,
     NumberLiteral,
     StringLiteral,
-    Punctuation,
+    LeftBrace,
+    RightBrace,
+    LeftBracket,
+    RightBracket,
+    Colon,
+    Comma,
+    Punctuation,  // Any other accepted punctuation: ';', '(' and ')'
     Eof
 };
 
+/**
+ * A token is a view into the input it was scanned from, so the input must
+ * outlive every token taken from it. String literal lexemes exclude the
+ * surrounding quotes and are kept undecoded, only those flagged as having
+ * escape sequences need to go through `unescape()`. Number literals follow
+ * the JSON grammar and are flagged when they have neither a fraction nor an
+ * exponent.
+ */
 struct Token {
-    TokenType type;
-    std::string lexeme;
-    size_t line;
-    size_t column;
+    TokenType type {TokenType::Eof};
+    bool has_escapes {false};
+    bool is_integer {false};
+    std::string_view lexeme;
+    size_t offset {0};  // Offset of the first byte of the token in the input
+
+    Token() = default;
 
     Token(
         TokenType type,
-        const std::string& lexeme,
-        size_t line,
-        size_t column
+        std::string_view lexeme,
+        size_t offset,
+        bool has_escapes = false
     ) :
         type(type),
+        has_escapes(has_escapes),
         lexeme(lexeme),
-        line(line),
-        column(column) {}
+        offset(offset) {}
+};
+
+/**
+ * @brief Decodes the escape sequences of a string literal lexeme.
+ *
+ * The lexeme must have been validated by the Tokenizer. Decoding never
+ * grows a literal, so `out` needs room for `lexeme.size()` bytes.
+ *
+ * @return The number of bytes written to `out`
+ */
+size_t unescape(std::string_view lexeme, char* out);
+
+enum class NumberKind : uint8_t { Int64, Uint64, Double };
+
+/**
+ * The value of a number literal. Non-negative integers are reported as
+ * Uint64, negative ones as Int64 and everything else as Double.
+ */
+struct Number {
+    NumberKind kind;
+
+    union {
+        int64_t int64;
+        uint64_t uint64;
+        double number;
+    };
+};
+
+/**
+ * @brief Parses a number literal validated by the Tokenizer.
+ *
+ * Reads straight from the input, independent of the current locale.
+ * Integers are kept exact when they fit in 64 bits.
+ *
+ * @return false if the literal is out of range for a double
+ */
+bool parse_number(const Token& token, Number& out);
+
+struct SourceLocation {
+    size_t line;
+    size_t column;
 };
 
+/**
+ * @brief Computes the 1-based line and column of an offset into `code`.
+ *
+ * Positions are only tracked as offsets while scanning, this is meant for
+ * reporting errors.
+ */
+SourceLocation locate(std::string_view code, size_t offset);
+
+/**
+ * A malformed token: what is wrong and the offset it was found at. The
+ * detail is a view into the input, the parser turns errors into
+ * ParseErrors, locating them and copying the detail, before it goes away.
+ */
 class TokenizeError {
   public:
-    template<typename... Args>
-    TokenizeError(size_t line, size_t column, Args&&... args) :
-        m_line(line),
-        m_column(column) {
-        std::ostringstream oss;
-        (oss << ... << args);  // Fold expression to concatenate arguments
-        m_message = oss.str();
-    }
+    TokenizeError(
+        ::brace::ErrorCode code,
+        size_t offset,
+        std::string_view detail = {}
+    ) :
+        m_detail(detail),
+        m_offset(offset),
+        m_code(code) {}
 
-    std::string_view message() const {
-        return m_message;
+    ::brace::ErrorCode code() const {
+        return m_code;
     }
 
-    size_t line() const {
-        return m_line;
+    size_t offset() const {
+        return m_offset;
     }
 
-    size_t column() const {
-        return m_line;
+    std::string_view detail() const {
+        return m_detail;
     }
 
-    operator std::string() const {
-        return m_message;
+    const char* message() const {
+        return ::brace::describe(m_code);
     }
 
   private:
-    std::string m_message;
-    size_t m_line;
-    size_t m_column;
+    std::string_view m_detail;
+    size_t m_offset;
+    ::brace::ErrorCode m_code;
 };
 
 class Tokenizer {
   public:
+    /**
+     * @brief Scans the whole input and returns every token, ending with Eof.
+     */
     ::brace::Result<std::vector<Token>, TokenizeError>
-    tokenize(const std::string& code);
+    tokenize(std::string_view code);
+
+    /**
+     * @brief Rewinds the tokenizer to `offset` of a new input.
+     *
+     * The offset must be the start of a token or of whitespace before one.
+     *
+     * @param padded Whether `::brace::input_padding` bytes past the end of
+     *        `code` can be read
+     */
+    void reset(std::string_view code, size_t offset = 0, bool padded = false);
+
+    /**
+     * @brief Scans and returns the next token of `code`.
+     *
+     * Once the input is exhausted every further call returns an Eof token,
+     * so a parser can pull tokens on demand without buffering them.
+     */
+    ::brace::Result<Token, TokenizeError> next_token(std::string_view code);
+
+    /**
+     * @brief Scans the single token starting at `offset` of `code`.
+     *
+     * Meant for looking at tokens found through a structural index in any
+     * order. The tokenizer is left positioned after the token.
+     */
+    ::brace::Result<Token, TokenizeError>
+    scan_token(std::string_view code, size_t offset);
+
+    /**
+     * @brief Retrieves the offset the tokenizer stopped at.
+     *
+     * After an error this is where the problem was found.
+     */
+    size_t position() const {
+        return m_current;
+    }
 
   private:
-    size_t m_line {0};
-    size_t m_column {0};
     size_t m_current {0};
-    std::vector<Token> m_tokens;
+    size_t m_token_start {0};
 
-    bool is_at_end(const std::string& code) const {
+    // Token offsets of the window of input indexed so far, used to jump
+    // over whitespace. Inputs with comments are scanned byte by byte.
+    StructuralIndexer m_indexer;
+    size_t m_next_structural {0};
+    bool m_use_index {false};
+    bool m_padded {false};
+
+    bool is_at_end(std::string_view code) const {
         return m_current >= code.length();
     }
 
-    char peek(const std::string& code) {
+    char peek(std::string_view code) {
         if (is_at_end(code)) {
             return '\0';
         }
         return code[m_current];
     }
 
-    char peek_next(const std::string& code) const {
+    char peek_next(std::string_view code) const {
         if (m_current + 1 >= code.length()) {
             return '\0';
         }
         return code[m_current + 1];
     }
 
-    char advance(const std::string& code) {
-        char c = code[m_current];
-        m_current++;
-        if (c == '\n') {
-            m_line++;
-            m_column = 1;
-        } else {
-            m_column++;
-        }
-        return c;
+    char advance(std::string_view code) {
+        return code[m_current++];
     }
 
-    inline void add_token(TokenType type, const std::string& lexeme) {
-        m_tokens.emplace_back(type, lexeme, m_line, m_column - lexeme.length());
+    inline Token make_token(
+        TokenType type,
+        std::string_view lexeme,
+        bool has_escapes = false
+    ) const {
+        return Token(type, lexeme, m_token_start, has_escapes);
     }
 
-    inline void add_token(TokenType type) {
-        add_token(type, "");
+    TokenizeError
+    error(::brace::ErrorCode code, std::string_view detail = {}) const {
+        return TokenizeError(code, m_current, detail);
     }
 
     template<typename T, typename E>
     using Result = ::brace::Result<T, E>;
-    using Unit = ::brace::Unit;
-
-    void skip_whitespace(const std::string& code);
-    Result<Unit, TokenizeError> scan_tokens(const std::string& code);
-    Result<Unit, TokenizeError> keyword(const std::string& code);
-    Result<Unit, TokenizeError> number(const std::string& code);
-    Result<Unit, TokenizeError> string(const std::string& code);
-    Result<Unit, TokenizeError> punctuation(const std::string& code);
+
+    void skip_whitespace(std::string_view code);
+    void skip_to_next_token(std::string_view code);
+    Result<Token, TokenizeError> keyword(std::string_view code);
+    Result<Token, TokenizeError> number(std::string_view code);
+    Result<Token, TokenizeError> string(std::string_view code);
+    bool unicode_escape(std::string_view code);
+    Result<Token, TokenizeError> punctuation(std::string_view code);
 };
 
 }  // namespace priv::brace
@@ -1,140 +1,740 @@
 #include <brace/brace.h>
+#include <brace/sax.h>
+#include <priv/brace/dom_builder.h>
+#include <priv/brace/key_table.h>
+#include <priv/brace/mapped_file.h>
+#include <priv/brace/stats.h>
 
 #include <algorithm>
+#include <optional>
+#include <stdexcept>
 
 namespace brace {
 
 using Token = ::priv::brace::Token;
 using TokenType = ::priv::brace::TokenType;
-using Tokenizer = ::priv::brace::Tokenizer;
+using TokenizeError = ::priv::brace::TokenizeError;
+using DomBuilder = ::priv::brace::DomBuilder;
+using KeyTable = ::priv::brace::KeyTable;
+using StringTable = ::priv::brace::StringTable;
 
-Result<JsonValue, ParseError> Parser::parse(const std::string& json) {
-    Tokenizer tokenizer;
-    auto maybe_tokens = tokenizer.tokenize(json);
+ParseStats& ParseStats::operator+=(const ParseStats& other) {
+    bytes_scanned += other.bytes_scanned;
+    keywords += other.keywords;
+    numbers += other.numbers;
+    strings += other.strings;
+    braces += other.braces;
+    brackets += other.brackets;
+    colons += other.colons;
+    commas += other.commas;
+    punctuation += other.punctuation;
+    max_depth = std::max(max_depth, other.max_depth);
+    allocations += other.allocations;
+    allocated_bytes += other.allocated_bytes;
+    tokenize_time += other.tokenize_time;
+    number_time += other.number_time;
+    container_time += other.container_time;
+    return *this;
+}
+
+// Allocates and constructs a heap representation from `resource`
+template<typename T, typename... Args>
+static T* create(std::pmr::memory_resource* resource, Args&&... args) {
+    void* storage = resource->allocate(sizeof(T), alignof(T));
+    ::priv::brace::count_allocation(sizeof(T));
+    return new (storage) T(std::forward<Args>(args)...);
+}
+
+template<typename T>
+static void dispose(T* container) {
+    std::pmr::memory_resource* resource = container->get_allocator().resource();
+    container->~T();
+    resource->deallocate(container, sizeof(T), alignof(T));
+}
+
+JsonValue::JsonValue(std::string_view s, std::pmr::memory_resource* resource) :
+    m_type(JsonType::String) {
+    init_string(s, resource);
+}
+
+JsonValue::JsonValue(const JsonObject& obj) : m_type(JsonType::Object) {
+    store(create<JsonObject>(std::pmr::get_default_resource(), obj));
+}
+
+JsonValue::JsonValue(JsonObject&& obj) : m_type(JsonType::Object) {
+    store(create<JsonObject>(obj.get_allocator().resource(), std::move(obj)));
+}
 
-    if (maybe_tokens.is_err()) {
-        auto err = maybe_tokens.unwrap_err();
-        return ParseError(err.line(), err.column(), err.message());
+JsonValue::JsonValue(const JsonArray& arr) : m_type(JsonType::Array) {
+    store(create<JsonArray>(std::pmr::get_default_resource(), arr));
+}
+
+JsonValue::JsonValue(JsonArray&& arr) : m_type(JsonType::Array) {
+    store(create<JsonArray>(arr.get_allocator().resource(), std::move(arr)));
+}
+
+JsonValue::JsonValue(const JsonValue& other) : m_type(other.m_type) {
+    if (other.is_shared()) {
+        other.shared_header()->refs.fetch_add(1, std::memory_order_relaxed);
+        std::memcpy(m_data, other.m_data, sizeof(m_data));
+        m_string_size = shared_rep;
+        return;
+    }
+
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource();
+    switch (other.m_type) {
+        case JsonType::String:
+            // Copies own their string, interned ones included
+            if (other.m_string_size > max_inline_size) {
+                init_string(other.string_view(), resource);
+                return;
+            }
+            break;
+        case JsonType::Object:
+            store(create<JsonObject>(resource, *other.load<JsonObject*>()));
+            return;
+        case JsonType::Array:
+            store(create<JsonArray>(resource, *other.load<JsonArray*>()));
+            return;
+        default: break;
     }
 
-    m_tokens = maybe_tokens.unwrap_ok();
-    m_current = 0;
-    return parse_value();
+    // Scalars and inline strings are copied as they are
+    std::memcpy(m_data, other.m_data, sizeof(m_data));
+    m_string_size = other.m_string_size;
 }
 
-Result<JsonValue, ParseError> Parser::parse_value() {
-    const Token& token = peek();
-    std::string lowercase_lexeme = token.lexeme;
-    std::transform(
-        lowercase_lexeme.begin(),
-        lowercase_lexeme.end(),
-        lowercase_lexeme.begin(),
-        [](unsigned char c) { return std::tolower(c); }
+void JsonValue::init_string(
+    std::string_view s,
+    std::pmr::memory_resource* resource
+) {
+    if (s.size() <= max_inline_size) {
+        std::memcpy(m_data, s.data(), s.size());
+        m_string_size = static_cast<uint8_t>(s.size());
+        return;
+    }
+
+    void* storage = resource->allocate(
+        sizeof(StringRep) + s.size(),
+        alignof(StringRep)
     );
+    ::priv::brace::count_allocation(sizeof(StringRep) + s.size());
+    StringRep* rep = new (storage) StringRep {resource, s.size()};
+    std::memcpy(rep->chars(), s.data(), s.size());
+    m_string_size = heap_string;
+    store(rep);
+}
 
-    if (token.type == TokenType::StringLiteral) {
-        advance();
-        return JsonValue(token.lexeme);
-    } else if (token.type == TokenType::NumberLiteral) {
-        advance();
-        return JsonValue(std::stod(token.lexeme));
-    } else if (token.type == TokenType::Punctuation && token.lexeme == "{") {
-        auto res = parse_object();
-        if (res.is_ok()) {
-            return JsonValue(res.unwrap_ok());
+void* JsonValue::allocate_shared(
+    std::pmr::memory_resource* resource,
+    size_t size
+) {
+    void* storage =
+        resource->allocate(sizeof(SharedHeader) + size, alignof(SharedHeader));
+    ::priv::brace::count_allocation(sizeof(SharedHeader) + size);
+    SharedHeader* header = new (storage) SharedHeader;
+    header->refs.store(1, std::memory_order_relaxed);
+    return header + 1;
+}
+
+JsonValue JsonValue::shared_string(
+    std::string_view s,
+    std::pmr::memory_resource* resource
+) {
+    JsonValue value;
+    value.m_type = JsonType::String;
+    if (s.size() <= max_inline_size) {
+        value.init_string(s, resource);
+        return value;
+    }
+
+    void* storage = allocate_shared(resource, sizeof(StringRep) + s.size());
+    StringRep* rep = new (storage) StringRep {resource, s.size()};
+    std::memcpy(rep->chars(), s.data(), s.size());
+    value.m_string_size = shared_rep;
+    value.store(rep);
+    return value;
+}
+
+JsonValue JsonValue::shared_object(JsonObject&& obj) {
+    JsonValue value;
+    std::pmr::memory_resource* resource = obj.get_allocator().resource();
+    void* storage = allocate_shared(resource, sizeof(JsonObject));
+    value.store(new (storage) JsonObject(std::move(obj)));
+    value.m_string_size = shared_rep;
+    value.m_type = JsonType::Object;
+    return value;
+}
+
+JsonValue JsonValue::shared_array(JsonArray&& arr) {
+    JsonValue value;
+    std::pmr::memory_resource* resource = arr.get_allocator().resource();
+    void* storage = allocate_shared(resource, sizeof(JsonArray));
+    value.store(new (storage) JsonArray(std::move(arr)));
+    value.m_string_size = shared_rep;
+    value.m_type = JsonType::Array;
+    return value;
+}
+
+JsonValue JsonValue::share() const {
+    if (is_shared() || m_type < JsonType::String) {
+        return *this;
+    }
+
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource();
+    switch (m_type) {
+        case JsonType::String: return shared_string(string_view(), resource);
+        case JsonType::Object: {
+            const JsonObject& members = *load<JsonObject*>();
+            JsonObject object(resource);
+            object.reserve(members.size());
+            for (const auto& [key, value] : members) {
+                object.insert_or_assign(JsonKey(key.view(), resource), value.share());
+            }
+            return shared_object(std::move(object));
+        }
+        default: {
+            const JsonArray& elements = *load<JsonArray*>();
+            JsonArray array(resource);
+            array.reserve(elements.size());
+            for (const JsonValue& element : elements) {
+                array.push_back(element.share());
+            }
+            return shared_array(std::move(array));
+        }
+    }
+}
+
+void JsonValue::release_shared() noexcept {
+    SharedHeader* header = shared_header();
+    if (header->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    std::pmr::memory_resource* resource;
+    size_t size;
+    switch (m_type) {
+        case JsonType::String: {
+            StringRep* rep = load<StringRep*>();
+            resource = rep->resource;
+            size = sizeof(StringRep) + rep->size;
+            break;
         }
-        return res.unwrap_err();
-    } else if (token.type == TokenType::Punctuation && token.lexeme == "[") {
-        auto res = parse_array();
-        if (res.is_ok()) {
-            return JsonValue(res.unwrap_ok());
+        case JsonType::Object: {
+            JsonObject* object = load<JsonObject*>();
+            resource = object->get_allocator().resource();
+            size = sizeof(JsonObject);
+            object->~JsonObject();
+            break;
         }
-        return res.unwrap_err();
-    } else if (token.type == TokenType::Keyword) {
-        if (lowercase_lexeme == "true" || lowercase_lexeme == "false") {
-            advance();
-            return JsonValue(lowercase_lexeme == "true");
-        } else if (lowercase_lexeme == "null") {
-            advance();
-
-            return JsonValue();
+        default: {
+            JsonArray* array = load<JsonArray*>();
+            resource = array->get_allocator().resource();
+            size = sizeof(JsonArray);
+            array->~JsonArray();
+            break;
         }
     }
+    header->~SharedHeader();
+    resource->deallocate(
+        header,
+        sizeof(SharedHeader) + size,
+        alignof(SharedHeader)
+    );
+}
+
+void JsonValue::destroy() noexcept {
+    if (is_shared()) {
+        release_shared();
+        m_string_size = 0;
+        m_type = JsonType::Null;
+        return;
+    }
+
+    switch (m_type) {
+        case JsonType::String:
+            if (m_string_size == heap_string) {
+                StringRep* rep = load<StringRep*>();
+                rep->resource->deallocate(
+                    rep,
+                    sizeof(StringRep) + rep->size,
+                    alignof(StringRep)
+                );
+            }
+            break;
+        case JsonType::Object: dispose(load<JsonObject*>()); break;
+        case JsonType::Array: dispose(load<JsonArray*>()); break;
+        default: break;
+    }
+    m_type = JsonType::Null;
+}
 
-    return ParseError(
-        token.line,
-        token.column,
-        "Unexpected token: ",
-        token.lexeme
+void JsonKey::init(std::string_view key, std::pmr::memory_resource* resource) {
+    if (key.size() <= max_inline_size) {
+        std::memcpy(m_data, key.data(), key.size());
+        m_size = static_cast<uint8_t>(key.size());
+        return;
+    }
+
+    void* storage = resource->allocate(sizeof(Rep) + key.size(), alignof(Rep));
+    ::priv::brace::count_allocation(sizeof(Rep) + key.size());
+    Rep* rep = new (storage)
+        Rep {resource, std::hash<std::string_view>()(key), key.size()};
+    std::memcpy(rep->chars(), key.data(), key.size());
+    std::memcpy(m_data, &rep, sizeof(rep));
+    m_size = rep_key;
+}
+
+void JsonKey::destroy() noexcept {
+    if (m_size != rep_key) {
+        return;
+    }
+    const Rep* rep = load_rep();
+    if (rep->resource) {
+        rep->resource->deallocate(
+            const_cast<Rep*>(rep),
+            sizeof(Rep) + rep->size,
+            alignof(Rep)
+        );
+    }
+    m_size = 0;
+}
+
+// Smallest hash index built, in slots
+static constexpr size_t min_index_size = 2 * JsonObject::index_threshold;
+
+JsonValue& JsonObject::at(std::string_view key) {
+    size_t position = find_member(key);
+    if (position == size()) {
+        throw std::out_of_range("JsonObject::at: no such key");
+    }
+    return m_members[position].second;
+}
+
+const JsonValue& JsonObject::at(std::string_view key) const {
+    size_t position = find_member(key);
+    if (position == size()) {
+        throw std::out_of_range("JsonObject::at: no such key");
+    }
+    return m_members[position].second;
+}
+
+JsonValue& JsonObject::operator[](std::string_view key) {
+    size_t position = find_member(key);
+    if (position != size()) {
+        return m_members[position].second;
+    }
+    auto [it, inserted] = insert_or_assign(
+        JsonKey(key, get_allocator().resource()),
+        JsonValue()
     );
+    return it->second;
 }
 
-Result<JsonObject, ParseError> Parser::parse_object() {
-    JsonObject object;
-    advance();  // Consume '{'
+std::pair<JsonObject::iterator, bool>
+JsonObject::insert_or_assign(JsonKey key, JsonValue value) {
+    // Hashed only for the index, which keys stored out of line save
+    size_t position =
+        m_index.empty() ? find_linear(key) : find_indexed(key, key.hash());
+    if (position != size()) {
+        m_members[position].second = std::move(value);
+        return {begin() + position, false};
+    }
+
+    m_members.emplace_back(std::move(key), std::move(value));
+    if (!m_index.empty()) {
+        index_member(size() - 1);
+    } else if (size() > index_threshold) {
+        rebuild_index();
+    }
+    return {end() - 1, true};
+}
+
+size_t JsonObject::erase(std::string_view key) {
+    size_t position = find_member(key);
+    if (position == size()) {
+        return 0;
+    }
 
-    while (!is_at_end() && peek().lexeme != "}") {
-        const Token& key_token = advance();  // Key
-        if (key_token.type != TokenType::StringLiteral) {
-            return ParseError(
-                key_token.line,
-                key_token.column,
-                "Expected string key in object"
-            );
+    m_members.erase(begin() + position);
+    // Positions after the erased member have shifted
+    if (size() > index_threshold) {
+        rebuild_index();
+    } else {
+        m_index.clear();
+    }
+    return 1;
+}
+
+size_t JsonObject::find_indexed(std::string_view key, size_t hash) const {
+    size_t mask = m_index.size() - 1;
+    size_t slot = hash & mask;
+    for (;; slot = (slot + 1) & mask) {
+        uint32_t entry = m_index[slot];
+        if (entry == 0) {
+            return size();
+        } else if (m_members[entry - 1].first == key) {
+            return entry - 1;
         }
-        std::string key = key_token.lexeme;
-
-        const Token& colon = advance();
-        if (colon.lexeme != ":") {
-            return ParseError(
-                colon.line,
-                colon.column,
-                "Expected ':' after key in object"
-            );
+    }
+}
+
+void JsonObject::index_member(size_t position) {
+    // Kept at most half full so that probe sequences stay short
+    if (size() * 2 > m_index.size()) {
+        rebuild_index();
+        return;
+    }
+
+    size_t mask = m_index.size() - 1;
+    size_t slot = m_members[position].first.hash() & mask;
+    while (m_index[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    m_index[slot] = static_cast<uint32_t>(position + 1);
+}
+
+void JsonObject::rebuild_index() {
+    size_t capacity = min_index_size;
+    while (capacity < size() * 2) {
+        capacity *= 2;
+    }
+
+    size_t reserved = m_index.capacity();
+    m_index.assign(capacity, 0);
+    if (m_index.capacity() != reserved) {
+        ::priv::brace::count_allocation(capacity * sizeof(uint32_t));
+    }
+    for (size_t i = 0; i < size(); i++) {
+        index_member(i);
+    }
+}
+
+// The arena of a Document. Its first block is a buffer that outlives
+// resets, anything that does not fit is requested from upstream through the
+// arena itself, which keeps count so that the buffer can grow to fit it all
+// at the next reset.
+class Document::Arena: public std::pmr::memory_resource {
+  public:
+    Arena(std::pmr::memory_resource* upstream, size_t size) :
+        m_upstream(upstream),
+        m_keys(upstream),
+        m_strings(upstream) {
+        allocate_buffer(size);
+        start();
+    }
+
+    ~Arena() override {
+        m_resource.reset();
+        free_buffer();
+    }
+
+    std::pmr::memory_resource* resource() {
+        return &*m_resource;
+    }
+
+    KeyTable& keys() {
+        return m_keys;
+    }
+
+    StringTable& strings() {
+        return m_strings;
+    }
+
+    void reset() {
+        m_resource.reset();  // Hands the overflow back upstream
+        if (m_overflow) {
+            size_t size = m_size + m_overflow;
+            free_buffer();
+            allocate_buffer(size);
+            m_overflow = 0;
         }
+        start();
+    }
 
-        TRY_ASSIGN(value, parse_value());
+  private:
+    std::pmr::memory_resource* m_upstream;
+    void* m_buffer {nullptr};
+    size_t m_size {0};
+    // Bytes requested from upstream since the last reset
+    size_t m_overflow {0};
+    std::optional<std::pmr::monotonic_buffer_resource> m_resource;
+    // Keys interned since the last reset, their blocks live in the arena
+    KeyTable m_keys;
+    // Likewise for strings
+    StringTable m_strings;
+
+    void start() {
+        if (m_size) {
+            m_resource.emplace(m_buffer, m_size, this);
+        } else {
+            m_resource.emplace(this);
+        }
+        m_keys.reset(resource());
+        m_strings.reset(resource(), false);
+    }
 
-        object[key] = value;
+    void allocate_buffer(size_t size) {
+        if (size) {
+            m_buffer = m_upstream->allocate(size, alignof(std::max_align_t));
+            m_size = size;
+        }
+    }
 
-        const Token& next = peek();
-        if (next.lexeme == ",") {
-            advance();  // Consume ','
-        } else if (next.lexeme != "}") {
-            return ParseError(
-                next.line,
-                next.column,
-                "Expected ',' or '}' in object"
-            );
+    void free_buffer() {
+        if (m_buffer) {
+            m_upstream->deallocate(m_buffer, m_size, alignof(std::max_align_t));
+            m_buffer = nullptr;
+            m_size = 0;
         }
     }
 
-    advance();  // Consume '}'
-    return object;
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        m_overflow += bytes;
+        return m_upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        m_upstream->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other
+    ) const noexcept override {
+        return this == &other;
+    }
+};
+
+Document::Document(std::pmr::memory_resource* upstream, size_t initial_size) :
+    m_arena(std::make_unique<Arena>(upstream, initial_size)) {
+    set_root(JsonValue());
 }
 
-Result<JsonArray, ParseError> Parser::parse_array() {
-    JsonArray array;
-    advance();  // Consume '['
+Document::~Document() = default;
 
-    while (!is_at_end() && peek().lexeme != "]") {
-        TRY_ASSIGN_MOVE(value, parse_value());
-        array.emplace_back(value);
+Document::Document(Document&& other) noexcept :
+    m_arena(std::move(other.m_arena)),
+    m_root(std::exchange(other.m_root, nullptr)) {}
 
-        const Token& next = peek();
-        if (next.lexeme == ",") {
-            advance();  // Consume ','
-        } else if (next.lexeme != "]") {
-            return ParseError(
-                next.line,
-                next.column,
-                "Expected ',' or ']' in array"
-            );
-        }
+Document& Document::operator=(Document&& other) noexcept {
+    m_arena = std::move(other.m_arena);
+    m_root = std::exchange(other.m_root, nullptr);
+    return *this;
+}
+
+std::pmr::memory_resource* Document::resource() const {
+    return m_arena->resource();
+}
+
+void Document::reset() {
+    assert(m_arena && "Document has been moved from");
+    m_arena->reset();
+    set_root(JsonValue());
+}
+
+void Document::set_root(JsonValue&& value) {
+    // The previous root, if any, is abandoned along with its arena memory
+    void* storage =
+        resource()->allocate(sizeof(JsonValue), alignof(JsonValue));
+    m_root = new (storage) JsonValue(std::move(value));
+}
+
+Result<JsonValue, ParseError> Parser::parse(std::string_view json) {
+    return parse_root(json, m_resource, false, nullptr, m_shared_values);
+}
+
+Result<JsonValue, ParseError> Parser::parse(PaddedInput input) {
+    return parse_root(input.view(), m_resource, true, nullptr, m_shared_values);
+}
+
+Result<Document, ParseError> Parser::parse_document(std::string_view json) {
+    return build_document(json, false);
+}
+
+Result<Document, ParseError> Parser::parse_document(PaddedInput input) {
+    return build_document(input.view(), true);
+}
+
+Result<Unit, ParseError>
+Parser::parse_document(std::string_view json, Document& document) {
+    return fill_document(json, false, document);
+}
+
+Result<Unit, ParseError>
+Parser::parse_document(PaddedInput input, Document& document) {
+    return fill_document(input.view(), true, document);
+}
+
+Result<Document, ParseError>
+Parser::build_document(std::string_view json, bool padded) {
+    // The DOM usually needs a small multiple of its source text, start with
+    // that so that typical documents fit into a single arena block
+    constexpr size_t min_block_size = 4096;
+    Document document(m_resource, std::max(json.size() * 2, min_block_size));
+    TRY_ASSIGN_MOVE(
+        root,
+        parse_root(
+            json,
+            document.resource(),
+            padded,
+            document_keys(document),
+            false,
+            document_strings(document)
+        )
+    );
+    document.set_root(std::move(root));
+    return document;
+}
+
+Result<Unit, ParseError> Parser::fill_document(
+    std::string_view json,
+    bool padded,
+    Document& document
+) {
+    document.reset();
+    TRY_ASSIGN_MOVE(
+        root,
+        parse_root(
+            json,
+            document.resource(),
+            padded,
+            document_keys(document),
+            false,
+            document_strings(document)
+        )
+    );
+    document.set_root(std::move(root));
+    return Unit {};
+}
+
+Result<JsonValue, ParseError> Parser::parse_file(const std::string& path) {
+    ::priv::brace::MappedFile file;
+    TRY(file.open(path));
+    return parse_root(
+        file.contents(),
+        m_resource,
+        false,
+        nullptr,
+        m_shared_values
+    );
+}
+
+KeyTable* Parser::document_keys(Document& document) const {
+    return m_intern_keys ? &document.m_arena->keys() : nullptr;
+}
+
+StringTable* Parser::document_strings(Document& document) const {
+    return m_intern_strings ? &document.m_arena->strings() : nullptr;
+}
+
+Result<JsonValue, ParseError> Parser::parse_root(
+    std::string_view json,
+    std::pmr::memory_resource* resource,
+    bool padded,
+    KeyTable* keys,
+    bool shared,
+    StringTable* strings
+) {
+    // Left over from a previous parse that failed
+    m_member_stack.clear();
+    m_element_stack.clear();
+    m_container_stack.clear();
+
+    ::priv::brace::StringScope scope(
+        m_strings,
+        resource,
+        !strings && shared && m_intern_strings
+    );
+    DomBuilder builder(
+        resource,
+        m_member_stack,
+        m_element_stack,
+        m_container_stack,
+        keys,
+        shared,
+        strings ? strings : scope.table()
+    );
+    auto parsed = run_sax(json, padded, builder);
+    if (parsed.is_err()) {
+        // Drop the values of the failed parse while their resource, maybe a
+        // document's arena, is still alive
+        m_member_stack.clear();
+        m_element_stack.clear();
+        m_container_stack.clear();
+        return std::move(parsed).unwrap_err();
     }
+    return builder.take_root();
+}
+
+Result<Unit, ParseError>
+Parser::start(std::string_view json, size_t offset, bool padded) {
+    m_json = json;
+    m_tokenizer.reset(json, offset, padded);
+    m_token = Token();
+    TRY(advance());  // Prime the lookahead token
+    return Unit {};
+}
+
+Result<Unit, ParseError> Parser::finish() {
+    // Tokens are pulled lazily, so scan whatever follows the value to still
+    // report malformed input after it
+    while (!is_at_end()) {
+        TRY(advance());
+    }
+    return Unit {};
+}
+
+Result<Token, ParseError> Parser::advance() {
+    size_t position = m_tokenizer.position();
+    auto next = [&] {
+        ::priv::brace::PhaseTimer timer(m_stats.tokenize_time);
+        return m_tokenizer.next_token(m_json);
+    }();
+    if (next.is_err()) {
+        const TokenizeError& err = next.unwrap_err();
+        return error_at(err.offset(), err.code(), err.detail());
+    }
+    if constexpr (ParseStats::enabled) {
+        m_stats.bytes_scanned += m_tokenizer.position() - position;
+        ::priv::brace::count_token(m_stats, next.unwrap_ok());
+    }
+
+    Token consumed = m_token;
+    m_token = next.unwrap_ok();
+    return consumed;
+}
 
-    advance();  // Consume ']'
-    return array;
+ParseError
+Parser::error_at(size_t offset, ErrorCode code, std::string_view detail) const {
+    auto location = ::priv::brace::locate(m_json, offset);
+    return ParseError(code, offset, location.line, location.column, detail);
+}
+
+std::string_view Parser::decode_string(const Token& token) {
+    // String literals without escapes are used straight from the input
+    if (!token.has_escapes) {
+        return token.lexeme;
+    }
+    m_scratch.resize(token.lexeme.size());
+    m_scratch.resize(::priv::brace::unescape(token.lexeme, m_scratch.data()));
+    return m_scratch;
 }
 
 }  // namespace brace
+
+namespace priv::brace {
+
+thread_local ParseStats* active_stats = nullptr;
+thread_local PhaseSampler phase_sampler;
+
+PhaseSampler::Clock::duration PhaseSampler::measure_overhead() {
+    // The quickest of a few back to back readings, the others were
+    // interrupted
+    auto least = Clock::duration::max();
+    for (int i = 0; i < 64; i++) {
+        auto start = Clock::now();
+        least = std::min(least, Clock::now() - start);
+    }
+    return least;
+}
+
+}  // namespace priv::brace
@@ -0,0 +1,55 @@
+#include <brace/error.h>
+
+namespace brace {
+
+const char* describe(ErrorCode code) {
+    switch (code) {
+        case ErrorCode::UnexpectedCharacter: return "Unexpected character";
+        case ErrorCode::UnknownKeyword: return "Unrecognized keyword";
+        case ErrorCode::InvalidNumber: return "Invalid number format";
+        case ErrorCode::UnterminatedString: return "Unterminated string literal";
+        case ErrorCode::InvalidEscape: return "Invalid escape sequence";
+        case ErrorCode::InvalidUnicodeEscape:
+            return "Invalid unicode escape sequence";
+        case ErrorCode::InvalidUtf8: return "Invalid UTF-8 in string literal";
+        case ErrorCode::UnexpectedToken: return "Unexpected token";
+        case ErrorCode::UnexpectedEnd: return "Unexpected end of input";
+        case ErrorCode::ExpectedKey: return "Expected string key in object";
+        case ErrorCode::ExpectedColon: return "Expected ':' after key in object";
+        case ErrorCode::ExpectedCommaOrBrace:
+            return "Expected ',' or '}' in object";
+        case ErrorCode::ExpectedCommaOrBracket:
+            return "Expected ',' or ']' in array";
+        case ErrorCode::NumberOutOfRange: return "Number out of range";
+        case ErrorCode::DepthExceeded: return "Maximum nesting depth exceeded";
+        case ErrorCode::ExpectedString: return "Expected a string";
+        case ErrorCode::ExpectedBool: return "Expected true or false";
+        case ErrorCode::ExpectedNumber: return "Expected a number";
+        case ErrorCode::ExpectedInteger: return "Expected an integer";
+        case ErrorCode::ExpectedArray: return "Expected an array";
+        case ErrorCode::ExpectedObject: return "Expected an object";
+        case ErrorCode::Cancelled: return "Parsing cancelled by handler";
+        case ErrorCode::InputTooLarge: return "Input too large";
+        case ErrorCode::InvalidPointer: return "Invalid JSON Pointer";
+        case ErrorCode::Io: return "I/O error";
+        case ErrorCode::InvalidSnapshot: return "Invalid snapshot";
+    }
+    return "Unknown error";
+}
+
+std::string ParseError::message() const {
+    std::string message = describe(m_code);
+    if (!m_detail.empty()) {
+        message += ": ";
+        message += m_detail;
+    }
+    if (m_line != 0) {
+        message += " at line ";
+        message += std::to_string(m_line);
+        message += ", column ";
+        message += std::to_string(m_column);
+    }
+    return message;
+}
+
+}  // namespace brace
@@ -0,0 +1,64 @@
+#include <priv/brace/key_table.h>
+#include <priv/brace/stats.h>
+
+#include <cstring>
+#include <functional>
+
+namespace priv::brace {
+
+// Smallest table built, in slots
+static constexpr size_t min_table_size = 64;
+
+KeyTable::JsonKey KeyTable::intern(std::string_view key) {
+    // Inline keys take no more room than a pointer to a shared one would,
+    // and are quicker to make than to look up
+    if (key.size() <= JsonKey::max_inline_size) {
+        return JsonKey(key);
+    }
+
+    if ((m_size + 1) * 2 > m_slots.size()) {
+        grow();
+    }
+
+    size_t hash = std::hash<std::string_view>()(key);
+    size_t mask = m_slots.size() - 1;
+    size_t slot = hash & mask;
+    for (; m_slots[slot]; slot = (slot + 1) & mask) {
+        const JsonKey::Rep* rep = m_slots[slot];
+        if (rep->hash == hash && std::string_view(rep->chars(), rep->size) == key) {
+            return JsonKey(rep);
+        }
+    }
+
+    void* storage = m_resource->allocate(
+        sizeof(JsonKey::Rep) + key.size(),
+        alignof(JsonKey::Rep)
+    );
+    count_allocation(sizeof(JsonKey::Rep) + key.size());
+    JsonKey::Rep* rep = new (storage) JsonKey::Rep {nullptr, hash, key.size()};
+    std::memcpy(rep->chars(), key.data(), key.size());
+    m_slots[slot] = rep;
+    m_size++;
+    return JsonKey(rep);
+}
+
+void KeyTable::grow() {
+    std::pmr::vector<const JsonKey::Rep*> slots(
+        std::max(m_slots.size() * 2, min_table_size),
+        nullptr,
+        m_slots.get_allocator()
+    );
+    size_t mask = slots.size() - 1;
+    for (const JsonKey::Rep* rep : m_slots) {
+        if (rep) {
+            size_t slot = rep->hash & mask;
+            while (slots[slot]) {
+                slot = (slot + 1) & mask;
+            }
+            slots[slot] = rep;
+        }
+    }
+    m_slots = std::move(slots);
+}
+
+}  // namespace priv::brace
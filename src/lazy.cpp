@@ -0,0 +1,409 @@
+#include <brace/lazy.h>
+#include <brace/path.h>
+
+#include <stdexcept>
+
+namespace brace {
+
+using Token = ::priv::brace::Token;
+using TokenType = ::priv::brace::TokenType;
+using Tokenizer = ::priv::brace::Tokenizer;
+using TokenizeError = ::priv::brace::TokenizeError;
+using StructuralIndexer = ::priv::brace::StructuralIndexer;
+
+namespace {
+
+ParseError error_at(
+    std::string_view json,
+    size_t offset,
+    ErrorCode code,
+    std::string_view detail = {}
+) {
+    auto location = ::priv::brace::locate(json, offset);
+    return ParseError(code, offset, location.line, location.column, detail);
+}
+
+ParseError to_parse_error(std::string_view json, const TokenizeError& err) {
+    return error_at(json, err.offset(), err.code(), err.detail());
+}
+
+bool is_scalar_start(char c) {
+    return c == '"' || c == '-' || (c >= '0' && c <= '9') || c == 't'
+        || c == 'f' || c == 'n';
+}
+
+// Whether a token may be directly followed by `c`. The structural index
+// starts a token at every such boundary, so anything else means the token
+// at hand was only partially valid.
+bool is_token_boundary(char c) {
+    switch (c) {
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+        case ',':
+        case ':':
+        case ']':
+        case '}':
+        case '/': return true;
+        default: return false;
+    }
+}
+
+// Parser states while checking the sequence of structural characters
+enum class Expect : uint8_t {
+    Value,
+    ValueOrClose,  // After '['
+    Key,
+    KeyOrClose,  // After '{'
+    Colon,
+    CommaOrClose,
+};
+
+// Reads the scalar token at `offset` and checks that it ends where the next
+// token starts
+Result<Token, ParseError> read_token(std::string_view json, size_t offset) {
+    Tokenizer tokenizer;
+    auto result = tokenizer.scan_token(json, offset);
+    if (result.is_err()) {
+        return to_parse_error(json, result.unwrap_err());
+    }
+
+    Token token = std::move(result).unwrap_ok();
+    size_t end = static_cast<size_t>(
+        token.lexeme.data() + token.lexeme.size() - json.data()
+    );
+    if (token.type == TokenType::StringLiteral) {
+        end++;  // Closing quote
+    }
+    if (end < json.size() && !is_token_boundary(json[end])) {
+        return error_at(json, end, ErrorCode::UnexpectedCharacter, json.substr(end, 1));
+    }
+    return token;
+}
+
+std::string decode(const Token& token) {
+    std::string text(token.lexeme.size(), '\0');
+    text.resize(::priv::brace::unescape(token.lexeme, text.data()));
+    return text;
+}
+
+}  // namespace
+
+Result<LazyDocument, ParseError> Parser::parse_lazy(std::string_view json) {
+    LazyDocument document;
+    TRY(document.build(json, m_max_depth));
+    return document;
+}
+
+Result<LazyDocument, ParseError> Parser::parse_lazy(const char* json) {
+    return parse_lazy(std::string_view(json));
+}
+
+Result<Unit, ParseError>
+LazyDocument::build(std::string_view json, size_t max_depth) {
+    m_json = json;
+    if (json.size() >= StructuralIndexer::max_input_size) {
+        return ParseError(ErrorCode::InputTooLarge, 0, 1, 1);
+    }
+
+    StructuralIndexer indexer;
+    if (indexer.scan_all(json)) {
+        m_structurals.assign(
+            indexer.structurals(),
+            indexer.structurals() + indexer.size()
+        );
+    } else {
+        // Comments can not be indexed, find the tokens the long way
+        Tokenizer tokenizer;
+        tokenizer.reset(json);
+        m_structurals.clear();
+        while (true) {
+            auto result = tokenizer.next_token(json);
+            if (result.is_err()) {
+                return to_parse_error(json, result.unwrap_err());
+            }
+            const Token& token = result.unwrap_ok();
+            if (token.type == TokenType::Eof) {
+                break;
+            }
+            m_structurals.push_back(static_cast<uint32_t>(token.offset));
+        }
+    }
+
+    return validate(max_depth);
+}
+
+Result<Unit, ParseError> LazyDocument::validate(size_t max_depth) {
+    std::string_view json = m_json;
+    m_jumps.assign(m_structurals.size(), 0);
+
+    // Positions of the brackets still open
+    std::vector<uint32_t> open;
+    Expect expect = Expect::Value;
+
+    for (size_t i = 0; i < m_structurals.size(); i++) {
+        size_t offset = m_structurals[i];
+        char c = json[offset];
+        bool closes = false;
+
+        switch (expect) {
+            case Expect::Value:
+            case Expect::ValueOrClose:
+                if (c == '{' || c == '[') {
+                    // Materializing values recurses into them
+                    if (open.size() >= max_depth) {
+                        return error_at(json, offset, ErrorCode::DepthExceeded);
+                    }
+                    open.push_back(static_cast<uint32_t>(i));
+                    expect = c == '{' ? Expect::KeyOrClose : Expect::ValueOrClose;
+                } else if (is_scalar_start(c)) {
+                    expect = Expect::CommaOrClose;
+                } else if (c == ']' && expect == Expect::ValueOrClose) {
+                    closes = true;
+                } else {
+                    return error_at(
+                        json,
+                        offset,
+                        ErrorCode::UnexpectedToken,
+                        json.substr(offset, 1)
+                    );
+                }
+                break;
+            case Expect::Key:
+            case Expect::KeyOrClose:
+                if (c == '"') {
+                    expect = Expect::Colon;
+                } else if (c == '}' && expect == Expect::KeyOrClose) {
+                    closes = true;
+                } else {
+                    return error_at(json, offset, ErrorCode::ExpectedKey);
+                }
+                break;
+            case Expect::Colon:
+                if (c != ':') {
+                    return error_at(json, offset, ErrorCode::ExpectedColon);
+                }
+                expect = Expect::Value;
+                break;
+            case Expect::CommaOrClose: {
+                bool in_object = json[m_structurals[open.back()]] == '{';
+                if (c == ',') {
+                    // A trailing comma may go before the close, like in
+                    // Parser::parse()
+                    expect = in_object ? Expect::KeyOrClose : Expect::ValueOrClose;
+                } else if (c == (in_object ? '}' : ']')) {
+                    closes = true;
+                } else {
+                    return error_at(
+                        json,
+                        offset,
+                        in_object ? ErrorCode::ExpectedCommaOrBrace
+                                  : ErrorCode::ExpectedCommaOrBracket
+                    );
+                }
+                break;
+            }
+        }
+
+        if (closes) {
+            m_jumps[open.back()] = static_cast<uint32_t>(i);
+            open.pop_back();
+            expect = Expect::CommaOrClose;
+        }
+        // Whatever follows the root value is ignored, like Parser does
+        if (open.empty() && expect == Expect::CommaOrClose) {
+            return Unit {};
+        }
+    }
+
+    return error_at(json, json.size(), ErrorCode::UnexpectedEnd);
+}
+
+size_t LazyDocument::skip(size_t position) const {
+    char c = first_byte(position);
+    if (c == '{' || c == '[') {
+        return m_jumps[position] + 1;
+    }
+    return position + 1;
+}
+
+LazyValue LazyDocument::root() const {
+    return LazyValue(this, 0);
+}
+
+JsonType LazyValue::type() const {
+    switch (first_byte()) {
+        case '{': return JsonType::Object;
+        case '[': return JsonType::Array;
+        case '"': return JsonType::String;
+        case 't':
+        case 'f': return JsonType::Bool;
+        case 'n': return JsonType::Null;
+        default: {
+            // Whether a number is an integer depends on its whole literal
+            auto value = get();
+            return value.is_ok() ? value.unwrap_ok().type() : JsonType::Double;
+        }
+    }
+}
+
+Result<JsonValue, ParseError> LazyValue::get() const {
+    std::string_view json = m_document->m_json;
+
+    if (is_object()) {
+        JsonObject object;
+        object.reserve(size());
+        size_t i = m_position + 1;
+        while (m_document->first_byte(i) != '}') {
+            TRY_ASSIGN(key, read_token(json, m_document->m_structurals[i]));
+            TRY_ASSIGN(value, LazyValue(m_document, i + 2).get());
+            object.insert_or_assign(
+                JsonKey(key.has_escapes ? decode(key) : key.lexeme),
+                std::move(value)
+            );
+            i = m_document->skip(i + 2);
+            if (m_document->first_byte(i) == ',') {
+                i++;
+            }
+        }
+        return JsonValue(std::move(object));
+    } else if (is_array()) {
+        JsonArray array;
+        array.reserve(size());
+        size_t i = m_position + 1;
+        while (m_document->first_byte(i) != ']') {
+            TRY_ASSIGN(value, LazyValue(m_document, i).get());
+            array.emplace_back(std::move(value));
+            i = m_document->skip(i);
+            if (m_document->first_byte(i) == ',') {
+                i++;
+            }
+        }
+        return JsonValue(std::move(array));
+    }
+
+    TRY_ASSIGN(token, read_token(json, m_document->m_structurals[m_position]));
+    if (token.type == TokenType::StringLiteral) {
+        return JsonValue(token.has_escapes ? decode(token) : std::string(token.lexeme));
+    } else if (token.type == TokenType::NumberLiteral) {
+        ::priv::brace::Number number;
+        if (!::priv::brace::parse_number(token, number)) {
+            return error_at(
+                json,
+                token.offset,
+                ErrorCode::NumberOutOfRange,
+                token.lexeme
+            );
+        }
+        switch (number.kind) {
+            case ::priv::brace::NumberKind::Int64: return JsonValue(number.int64);
+            case ::priv::brace::NumberKind::Uint64: return JsonValue(number.uint64);
+            default: return JsonValue(number.number);
+        }
+    } else if (token.lexeme == "true" || token.lexeme == "false") {
+        return JsonValue(token.lexeme == "true");
+    } else if (token.lexeme == "null") {
+        return JsonValue();
+    }
+    return error_at(json, token.offset, ErrorCode::UnexpectedToken, token.lexeme);
+}
+
+JsonValue LazyValue::get_scalar() const {
+    return get().expect("Malformed value");
+}
+
+LazyValue::operator std::string() const {
+    assert(is_string() && "LazyValue is not a string");
+    return std::string(get_scalar().to_string_view());
+}
+
+size_t LazyValue::size() const {
+    assert((is_object() || is_array()) && "LazyValue is not a container");
+    size_t step = is_object() ? 2 : 0;  // Values of members follow a key and ':'
+    size_t count = 0;
+    size_t i = m_position + 1;
+    while (m_document->first_byte(i) != '}' && m_document->first_byte(i) != ']') {
+        count++;
+        i = m_document->skip(i + step);
+        if (m_document->first_byte(i) == ',') {
+            i++;
+        }
+    }
+    return count;
+}
+
+size_t LazyValue::find_member(std::string_view key) const {
+    assert(is_object() && "LazyValue is not an object");
+    std::string_view json = m_document->m_json;
+
+    size_t i = m_position + 1;
+    while (m_document->first_byte(i) != '}') {
+        auto result = read_token(json, m_document->m_structurals[i]);
+        if (result.is_ok()) {
+            const Token& token = result.unwrap_ok();
+            if (token.has_escapes ? decode(token) == key : token.lexeme == key) {
+                return i + 2;
+            }
+        }
+        i = m_document->skip(i + 2);
+        if (m_document->first_byte(i) == ',') {
+            i++;
+        }
+    }
+    return 0;
+}
+
+bool LazyValue::contains(std::string_view key) const {
+    return is_object() && find_member(key) != 0;
+}
+
+LazyValue LazyValue::operator[](std::string_view key) const {
+    size_t position = find_member(key);
+    if (position == 0) {
+        throw std::out_of_range("LazyValue: no such key");
+    }
+    return LazyValue(m_document, position);
+}
+
+LazyValue LazyValue::operator[](size_t index) const {
+    assert(is_array() && "LazyValue is not an array");
+    size_t position = find_element(index);
+    if (position == 0) {
+        throw std::out_of_range("LazyValue: index out of bounds");
+    }
+    return LazyValue(m_document, position);
+}
+
+size_t LazyValue::find_element(size_t index) const {
+    size_t i = m_position + 1;
+    for (size_t n = 0; m_document->first_byte(i) != ']'; n++) {
+        if (n == index) {
+            return i;
+        }
+        i = m_document->skip(i);
+        if (m_document->first_byte(i) == ',') {
+            i++;
+        }
+    }
+    return 0;
+}
+
+std::optional<LazyValue> LazyValue::find(const Path& path) const {
+    LazyValue current = *this;
+    for (const Path::Step& step : path.steps()) {
+        size_t position = 0;
+        if (current.is_object()) {
+            position = current.find_member(step.key);
+        } else if (current.is_array() && step.index != Path::npos) {
+            position = current.find_element(step.index);
+        }
+        if (position == 0) {
+            return std::nullopt;
+        }
+        current.m_position = position;
+    }
+    return current;
+}
+
+}  // namespace brace
@@ -0,0 +1,165 @@
+#include <priv/brace/mapped_file.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace priv::brace {
+
+using ::brace::ParseError;
+using ::brace::Unit;
+
+template<typename T, typename E>
+using Result = ::brace::Result<T, E>;
+
+namespace {
+
+// Failing to `action` the file is not about its contents, so the error has
+// no location
+ParseError
+io_error(const char* action, const std::string& path, const std::string& reason) {
+    return ParseError(
+        ::brace::ErrorCode::Io,
+        0,
+        0,
+        0,
+        std::string(action) + " " + path + ": " + reason
+    );
+}
+
+}  // namespace
+
+#ifdef _WIN32
+
+MappedFile::~MappedFile() {
+    if (m_mapped) {
+        UnmapViewOfFile(m_data);
+    }
+}
+
+Result<Unit, ParseError>
+MappedFile::open(const std::string& path, bool sequential) {
+    HANDLE file = CreateFileA(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS,
+        nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE) {
+        return io_error(
+            "Could not open",
+            path,
+            "error " + std::to_string(GetLastError())
+        );
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        DWORD error = GetLastError();
+        CloseHandle(file);
+        return io_error(
+            "Could not read",
+            path,
+            "error " + std::to_string(error)
+        );
+    }
+    if (size.QuadPart == 0) {
+        // Empty files can not be mapped
+        CloseHandle(file);
+        return Unit {};
+    }
+
+    HANDLE mapping =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view =
+        mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    DWORD error = GetLastError();
+    // The view keeps the file mapped on its own
+    if (mapping) {
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    if (!view) {
+        return io_error(
+            "Could not map",
+            path,
+            "error " + std::to_string(error)
+        );
+    }
+
+    m_data = static_cast<const char*>(view);
+    m_size = static_cast<size_t>(size.QuadPart);
+    m_mapped = true;
+    return Unit {};
+}
+
+#else
+
+MappedFile::~MappedFile() {
+    if (m_mapped) {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+}
+
+Result<Unit, ParseError>
+MappedFile::open(const std::string& path, bool sequential) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return io_error("Could not open", path, std::strerror(errno));
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        size_t size = static_cast<size_t>(info.st_size);
+        void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            madvise(data, size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+            close(fd);
+            m_data = static_cast<const char*>(data);
+            m_size = size;
+            m_mapped = true;
+            return Unit {};
+        }
+    }
+
+    // Pipes, character devices and files whose size is not known up front
+    char chunk[64 * 1024];
+    while (true) {
+        ssize_t count = read(fd, chunk, sizeof(chunk));
+        if (count > 0) {
+            m_buffer.append(chunk, static_cast<size_t>(count));
+        } else if (count == 0) {
+            break;
+        } else if (errno != EINTR) {
+            int error = errno;
+            close(fd);
+            return io_error("Could not read", path, std::strerror(error));
+        }
+    }
+    close(fd);
+
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    return Unit {};
+}
+
+#endif
+
+}  // namespace priv::brace
@@ -0,0 +1,240 @@
+#include <brace/brace.h>
+#include <priv/brace/stats.h>
+#include <priv/brace/string_table.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace brace {
+
+namespace {
+
+// Inputs are handed to worker threads in batches of lines about this large
+constexpr size_t batch_size = 256 * 1024;
+
+// Batches parsed ahead of the one being delivered, per worker. Bounds the
+// memory held by records waiting for their turn.
+constexpr size_t batches_in_flight = 2;
+
+struct Record {
+    size_t line;  // Relative to the start of the batch
+    Result<JsonValue, ParseError> value;
+};
+
+struct Batch {
+    size_t begin;
+    size_t end;
+    size_t lines {0};  // Line feeds in the batch
+    std::vector<Record> records;
+    bool done {false};
+};
+
+bool is_blank(std::string_view line) {
+    return line.find_first_not_of(" \t\r") == std::string_view::npos;
+}
+
+// Parses the lines of input[begin, end), calling `emit(line, result)` for
+// each record with lines counted from 0. Stops when `emit` returns false.
+template<typename Emit>
+size_t parse_lines(
+    Parser& parser,
+    std::string_view input,
+    size_t begin,
+    size_t end,
+    Emit&& emit
+) {
+    size_t line = 0;
+    for (size_t start = begin; start < end; line++) {
+        const void* found =
+            std::memchr(input.data() + start, '\n', end - start);
+        size_t stop = found
+            ? static_cast<size_t>(static_cast<const char*>(found) - input.data())
+            : end;
+
+        std::string_view text(input.data() + start, stop - start);
+        start = stop + 1;
+        if (is_blank(text)) {
+            continue;
+        }
+
+        if (!emit(line, parser.parse(text))) {
+            break;
+        }
+    }
+    return line;
+}
+
+// Splits the input at line feeds into batches of at least `batch_size`
+std::vector<Batch> split_batches(std::string_view input) {
+    std::vector<Batch> batches;
+    size_t begin = 0;
+    while (begin < input.size()) {
+        size_t end = std::min(begin + batch_size, input.size());
+        const void* found =
+            std::memchr(input.data() + end, '\n', input.size() - end);
+        end = found
+            ? static_cast<size_t>(static_cast<const char*>(found) - input.data())
+                + 1
+            : input.size();
+        batches.push_back(Batch {begin, end, 0, {}, false});
+        begin = end;
+    }
+    return batches;
+}
+
+}  // namespace
+
+size_t Parser::parse_many(
+    std::string_view input,
+    const RecordHandler& handler,
+    size_t threads
+) {
+    // Records parsed on this thread add up to the stats of the whole input
+    ::priv::brace::StatsScope scope(m_stats);
+    // And so do their strings
+    ::priv::brace::StringScope strings(
+        m_strings,
+        m_resource,
+        m_shared_values && m_intern_strings
+    );
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    size_t delivered = 0;
+    if (threads == 1 || input.size() <= batch_size) {
+        parse_lines(
+            *this,
+            input,
+            0,
+            input.size(),
+            [&](size_t line, Result<JsonValue, ParseError>&& record) {
+                delivered++;
+                return handler(line + 1, std::move(record));
+            }
+        );
+        return delivered;
+    }
+
+    std::vector<Batch> batches = split_batches(input);
+    threads = std::min(threads, batches.size());
+
+    std::atomic<size_t> next_batch {0};
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_t next_delivery = 0;  // Guarded by `mutex`, as are `stop` and `done`
+    bool stop = false;
+    size_t window = threads * batches_in_flight;
+
+    auto work = [&] {
+        Parser parser;
+        parser.set_memory_resource(m_resource);
+        parser.set_max_depth(m_max_depth);
+        parser.set_shared_values(m_shared_values);
+        parser.set_intern_strings(m_intern_strings);
+        ::priv::brace::StatsScope worker_scope(parser.m_stats);
+        // Shared by the records the worker parses
+        ::priv::brace::StringScope worker_strings(
+            parser.m_strings,
+            m_resource,
+            m_shared_values && m_intern_strings
+        );
+
+        while (true) {
+            size_t index = next_batch.fetch_add(1);
+            if (index >= batches.size()) {
+                break;
+            }
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] {
+                    return stop || index < next_delivery + window;
+                });
+                if (stop) {
+                    break;
+                }
+            }
+
+            Batch& batch = batches[index];
+            batch.lines = parse_lines(
+                parser,
+                input,
+                batch.begin,
+                batch.end,
+                [&](size_t n, Result<JsonValue, ParseError>&& record) {
+                    batch.records.push_back(Record {n, std::move(record)});
+                    return true;
+                }
+            );
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                batch.done = true;
+            }
+            changed.notify_all();
+        }
+
+        if constexpr (ParseStats::enabled) {
+            std::lock_guard<std::mutex> lock(mutex);
+            m_stats += parser.m_stats;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    auto halt = [&] {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        changed.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    };
+
+    try {
+        for (size_t i = 0; i < threads; i++) {
+            workers.emplace_back(work);
+        }
+
+        size_t first_line = 1;
+        for (Batch& batch : batches) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return batch.done; });
+            }
+
+            bool proceed = true;
+            for (Record& record : batch.records) {
+                delivered++;
+                proceed = handler(first_line + record.line, std::move(record.value));
+                if (!proceed) {
+                    break;
+                }
+            }
+            first_line += batch.lines;
+            batch.records = std::vector<Record>();
+
+            if (!proceed) {
+                break;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                next_delivery++;
+            }
+            changed.notify_all();
+        }
+    } catch (...) {
+        halt();
+        throw;
+    }
+
+    halt();
+    return delivered;
+}
+
+}  // namespace brace
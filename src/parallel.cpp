@@ -0,0 +1,224 @@
+#include <brace/brace.h>
+#include <brace/sax.h>
+#include <priv/brace/dom_builder.h>
+#include <priv/brace/stats.h>
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace brace {
+
+using Token = ::priv::brace::Token;
+using TokenType = ::priv::brace::TokenType;
+using StructuralIndexer = ::priv::brace::StructuralIndexer;
+using DomBuilder = ::priv::brace::DomBuilder;
+
+namespace {
+
+// Inputs smaller than this are parsed on the calling thread
+constexpr size_t parallel_min_size = 1024 * 1024;
+
+// Ranges made per thread, so that threads done early pick up the slack
+constexpr size_t ranges_per_thread = 4;
+
+// How much input the partitioning scan indexes at a time
+constexpr size_t partition_window_size = 64 * 1024;
+
+// Finds the commas between elements of the root array that split it into
+// ranges of about `range_size` bytes. Returns the offsets of the '[', the
+// commas chosen and the closing ']', or nothing if the input is not an
+// array or can not be indexed. Whether ranges are well-formed is left to
+// the workers.
+std::vector<size_t> partition(std::string_view json, size_t range_size) {
+    StructuralIndexer indexer;
+    std::vector<size_t> bounds;
+    size_t depth = 0;
+    size_t next_split = range_size;
+
+    indexer.reset();
+    while (indexer.position() < json.size()) {
+        if (!indexer.scan(json, partition_window_size)) {
+            return {};
+        }
+
+        const uint32_t* structurals = indexer.structurals();
+        for (size_t i = 0; i < indexer.size(); i++) {
+            size_t offset = structurals[i];
+            char c = json[offset];
+            if (bounds.empty() && c != '[') {
+                return {};  // Not an array, or no root at all
+            }
+
+            if (c == '[' || c == '{') {
+                if (depth++ == 0) {
+                    bounds.push_back(offset);
+                }
+            } else if (c == ']' || c == '}') {
+                if (--depth == 0) {
+                    if (c != ']') {
+                        return {};
+                    }
+                    bounds.push_back(offset);
+                    return bounds;
+                }
+            } else if (c == ',' && depth == 1 && offset >= next_split) {
+                bounds.push_back(offset);
+                next_split = offset + range_size;
+            }
+        }
+    }
+
+    return {};  // The root array never ends
+}
+
+}  // namespace
+
+Result<JsonValue, ParseError>
+Parser::parse_parallel(std::string_view json, size_t threads) {
+    ::priv::brace::StatsScope scope(m_stats);
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (threads == 1 || json.size() < parallel_min_size || m_max_depth == 0) {
+        return parse(json);
+    }
+
+    size_t ranges = threads * ranges_per_thread;
+    std::vector<size_t> bounds = partition(json, json.size() / ranges + 1);
+    if (bounds.size() < 3) {
+        // Too small to split, malformed, or has comments. Sequential
+        // parsing reports errors the usual way.
+        return parse(json);
+    }
+
+    ranges = bounds.size() - 1;
+    threads = std::min(threads, ranges);
+    std::vector<JsonArray> slices;
+    std::vector<std::optional<ParseError>> errors(ranges);
+    slices.reserve(ranges);
+    for (size_t i = 0; i < ranges; i++) {
+        slices.emplace_back(m_resource);
+    }
+
+    std::atomic<size_t> next_range {0};
+    std::mutex stats_mutex;
+    auto work = [&] {
+        Parser parser;
+        parser.set_memory_resource(m_resource);
+        // Elements are nested in the root array
+        parser.set_max_depth(m_max_depth - 1);
+        parser.set_shared_values(m_shared_values);
+        parser.set_intern_strings(m_intern_strings);
+        ::priv::brace::StatsScope worker_scope(parser.m_stats);
+        // Shared by the worker's ranges
+        ::priv::brace::StringScope worker_strings(
+            parser.m_strings,
+            m_resource,
+            m_shared_values && m_intern_strings
+        );
+        while (true) {
+            size_t i = next_range.fetch_add(1);
+            if (i >= ranges) {
+                break;
+            }
+            auto result =
+                parser.parse_elements(json, bounds[i] + 1, bounds[i + 1], slices[i]);
+            if (result.is_err()) {
+                errors[i] = result.unwrap_err();
+            }
+        }
+
+        if constexpr (ParseStats::enabled) {
+            parser.m_stats.max_depth++;  // Counting the root array
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            m_stats += parser.m_stats;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threads; i++) {
+        workers.emplace_back(work);
+    }
+    work();  // The calling thread takes its share
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    for (auto& error : errors) {
+        if (error) {
+            return *error;
+        }
+    }
+
+    // Scan whatever follows the array like parse() does
+    TRY(start(json, bounds.back() + 1));
+    TRY(finish());
+
+    size_t size = 0;
+    for (const JsonArray& slice : slices) {
+        size += slice.size();
+    }
+    JsonArray array(m_resource);
+    array.reserve(size);
+    if constexpr (ParseStats::enabled) {
+        m_stats.brackets++;  // The '[' of the root array, split off up front
+        ::priv::brace::count_allocation(size * sizeof(JsonValue));
+    }
+    for (JsonArray& slice : slices) {
+        std::move(slice.begin(), slice.end(), std::back_inserter(array));
+    }
+    if (m_shared_values) {
+        return JsonValue::shared_array(std::move(array));
+    }
+    return JsonValue(std::move(array));
+}
+
+Result<Unit, ParseError> Parser::parse_elements(
+    std::string_view json,
+    size_t begin,
+    size_t end,
+    JsonArray& out
+) {
+    m_member_stack.clear();
+    m_element_stack.clear();
+    m_container_stack.clear();
+
+    DomBuilder builder(
+        out.get_allocator().resource(),
+        m_member_stack,
+        m_element_stack,
+        m_container_stack,
+        nullptr,
+        m_shared_values,
+        m_strings
+    );
+    ::priv::brace::SaxDriver<DomBuilder> driver(*this, builder);
+
+    TRY(start(json, begin));
+    // Like Parser::parse(), a trailing comma may go before the ']' that ends
+    // the last range. It may also be where the range begins.
+    bool after_comma = json[begin - 1] == ',';
+    while (true) {
+        if (after_comma && peek().offset == end
+            && peek().type == TokenType::RightBracket) {
+            return Unit {};
+        }
+        TRY(driver.parse_value());
+        out.push_back(builder.take_root());
+
+        const Token& next = peek();
+        if (next.offset == end) {
+            return Unit {};
+        } else if (next.type != TokenType::Comma || next.offset > end) {
+            return error_at(next, ErrorCode::ExpectedCommaOrBracket);
+        }
+        TRY(advance());  // Consume ','
+        after_comma = true;
+    }
+}
+
+}  // namespace brace
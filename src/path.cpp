@@ -0,0 +1,444 @@
+#include <brace/path.h>
+#include <brace/sax.h>
+#include <priv/brace/dom_builder.h>
+
+#include <algorithm>
+
+namespace brace {
+
+using DomBuilder = ::priv::brace::DomBuilder;
+
+namespace {
+
+// The array index a reference token stands for, Path::npos if it is not
+// one. Indices have no leading zeros and "-", the element past the end, is
+// never there to be found.
+size_t parse_index(std::string_view token) {
+    if (token.empty() || token.size() > 19 || (token[0] == '0' && token.size() > 1)) {
+        return Path::npos;
+    }
+    size_t index = 0;
+    for (char c : token) {
+        if (c < '0' || c > '9') {
+            return Path::npos;
+        }
+        index = index * 10 + static_cast<size_t>(c - '0');
+    }
+    return index;
+}
+
+// Follows the steps of `path` from `first` on, starting at `value`
+const JsonValue* follow(const JsonValue& value, const Path& path, size_t first) {
+    const JsonValue* current = &value;
+    for (size_t i = first; i < path.size(); i++) {
+        const Path::Step& step = path.steps()[i];
+        if (current->is_object()) {
+            const JsonObject& object = current->to_object();
+            auto member = object.find(step.key, step.hash);
+            if (member == object.end()) {
+                return nullptr;
+            }
+            current = &member->second;
+        } else if (current->is_array() && step.index < current->to_array().size()) {
+            current = &current->to_array()[step.index];
+        } else {
+            return nullptr;
+        }
+    }
+    return current;
+}
+
+// Follows the paths through parse events. The paths that the value about to
+// begin may lie on are kept on a stack of candidates, each open container
+// owning the range of those that go on inside of it. Values at the end of a
+// path are built with a DomBuilder, paths that lead past a scalar or out of
+// a container without a match are ruled out, and parsing stops once no path
+// is left pending.
+class PathFinder: public SaxHandler<PathFinder> {
+  public:
+    PathFinder(
+        const std::vector<Path>& paths,
+        std::vector<std::optional<JsonValue>>& values,
+        DomBuilder& builder
+    ) :
+        m_paths(paths),
+        m_values(values),
+        m_builder(builder),
+        m_settled(paths.size(), false),
+        m_pending(paths.size()) {
+        for (size_t i = 0; i < paths.size(); i++) {
+            m_candidates.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    // Whether parsing was stopped because every path was resolved
+    bool stopped() const {
+        return m_pending == 0;
+    }
+
+    size_t found() const {
+        return m_found;
+    }
+
+    bool on_null() {
+        return scalar([&] { m_builder.on_null(); });
+    }
+
+    bool on_bool(bool b) {
+        return scalar([&] { m_builder.on_bool(b); });
+    }
+
+    bool on_int64(int64_t n) {
+        return scalar([&] { m_builder.on_int64(n); });
+    }
+
+    bool on_uint64(uint64_t n) {
+        return scalar([&] { m_builder.on_uint64(n); });
+    }
+
+    bool on_double(double n) {
+        return scalar([&] { m_builder.on_double(n); });
+    }
+
+    bool on_string(std::string_view s) {
+        return scalar([&] { m_builder.on_string(s); });
+    }
+
+    bool on_key(std::string_view key) {
+        if (m_building) {
+            return m_builder.on_key(key);
+        }
+
+        // The member's value is reached by the paths of the object that
+        // step through this key
+        const Frame& frame = m_frames.back();
+        size_t depth = m_frames.size() - 1;
+        m_candidates.resize(frame.end);
+        for (size_t i = frame.begin; i < frame.end; i++) {
+            uint32_t path = m_candidates[i];
+            if (!m_settled[path] && m_paths[path].steps()[depth].key == key) {
+                m_candidates.push_back(path);
+            }
+        }
+        return true;
+    }
+
+    bool on_start_object() {
+        return start(true);
+    }
+
+    bool on_end_object(size_t members) {
+        return end(true, members);
+    }
+
+    bool on_start_array() {
+        return start(false);
+    }
+
+    bool on_end_array(size_t elements) {
+        return end(false, elements);
+    }
+
+  private:
+    struct Frame {
+        // Candidates going on inside the container
+        size_t begin;
+        size_t end;
+        bool is_object;
+        // Index of the next element of an array
+        size_t index;
+    };
+
+    const std::vector<Path>& m_paths;
+    std::vector<std::optional<JsonValue>>& m_values;
+    DomBuilder& m_builder;
+    std::vector<uint32_t> m_candidates;
+    std::vector<Frame> m_frames;
+    // Paths ending at the value being built
+    std::vector<uint32_t> m_targets;
+    // Whether each path has been found or ruled out. Paths stay on the
+    // candidates of the containers around where that happened.
+    std::vector<bool> m_settled;
+    // Where the candidates of the value begin in m_candidates
+    size_t m_selected {0};
+    // Depth of the value being built within itself, 0 while following paths
+    size_t m_building {0};
+    size_t m_pending;
+    size_t m_found {0};
+
+    template<typename Event>
+    bool scalar(Event&& event) {
+        if (m_building) {
+            event();
+            return true;
+        }
+
+        select();
+        if (!m_targets.empty()) {
+            event();
+            resolve(m_builder.take_root());
+        }
+        // Paths going on can not be followed into a scalar
+        rule_out(m_selected);
+        return m_pending != 0;
+    }
+
+    bool start(bool is_object) {
+        if (m_building) {
+            m_building++;
+            return is_object ? m_builder.on_start_object()
+                             : m_builder.on_start_array();
+        }
+
+        select();
+        if (!m_targets.empty()) {
+            m_building = 1;
+            return is_object ? m_builder.on_start_object()
+                             : m_builder.on_start_array();
+        }
+        m_frames.push_back(Frame {m_selected, m_candidates.size(), is_object, 0});
+        return true;
+    }
+
+    bool end(bool is_object, size_t size) {
+        if (m_building) {
+            if (is_object) {
+                m_builder.on_end_object(size);
+            } else {
+                m_builder.on_end_array(size);
+            }
+            if (--m_building == 0) {
+                resolve(m_builder.take_root());
+            }
+            return m_pending != 0;
+        }
+
+        // Candidates of the container were not found inside of it
+        Frame frame = m_frames.back();
+        m_frames.pop_back();
+        m_candidates.resize(frame.end);
+        rule_out(frame.begin);
+        return m_pending != 0;
+    }
+
+    // Narrows the candidates down to the paths reaching the value about to
+    // begin, and moves those ending at it to m_targets
+    void select() {
+        size_t depth = m_frames.size();
+        m_selected = 0;
+        if (!m_frames.empty()) {
+            Frame& frame = m_frames.back();
+            if (!frame.is_object) {
+                m_candidates.resize(frame.end);
+                for (size_t i = frame.begin; i < frame.end; i++) {
+                    uint32_t path = m_candidates[i];
+                    if (!m_settled[path]
+                        && m_paths[path].steps()[depth - 1].index == frame.index) {
+                        m_candidates.push_back(path);
+                    }
+                }
+                frame.index++;
+            }
+            m_selected = frame.end;
+        }
+
+        m_targets.clear();
+        size_t kept = m_selected;
+        for (size_t i = m_selected; i < m_candidates.size(); i++) {
+            uint32_t path = m_candidates[i];
+            if (m_paths[path].size() == depth) {
+                m_targets.push_back(path);
+            } else {
+                m_candidates[kept++] = path;
+            }
+        }
+        m_candidates.resize(kept);
+    }
+
+    // Hands a value built to the paths ending at it, and looks those going
+    // on up inside of it
+    void resolve(JsonValue&& value) {
+        size_t depth = m_frames.size();
+        for (size_t i = m_selected; i < m_candidates.size(); i++) {
+            uint32_t path = m_candidates[i];
+            const JsonValue* inner = follow(value, m_paths[path], depth);
+            if (settle(path) && inner) {
+                m_values[path] = *inner;
+                m_found++;
+            }
+        }
+        m_candidates.resize(m_selected);
+
+        for (size_t i = 0; i < m_targets.size(); i++) {
+            uint32_t path = m_targets[i];
+            if (!settle(path)) {
+                continue;
+            }
+            if (i + 1 < m_targets.size()) {
+                m_values[path] = value;
+            } else {
+                m_values[path] = std::move(value);
+            }
+            m_found++;
+        }
+        m_targets.clear();
+    }
+
+    void rule_out(size_t from) {
+        for (size_t i = from; i < m_candidates.size(); i++) {
+            settle(m_candidates[i]);
+        }
+        m_candidates.resize(from);
+    }
+
+    // Marks a path as found or ruled out, false if it already was
+    bool settle(uint32_t path) {
+        if (m_settled[path]) {
+            return false;
+        }
+        m_settled[path] = true;
+        m_pending--;
+        return true;
+    }
+};
+
+}  // namespace
+
+Result<Path, ParseError> Path::compile(std::string_view pointer) {
+    Path path;
+    if (pointer.empty()) {
+        return path;
+    } else if (pointer[0] != '/') {
+        return ParseError(ErrorCode::InvalidPointer, 0, 1, 1, "expected '/'");
+    }
+
+    size_t begin = 1;
+    while (true) {
+        size_t end = std::min(pointer.find('/', begin), pointer.size());
+        Step step;
+        for (size_t i = begin; i < end; i++) {
+            char c = pointer[i];
+            if (c == '~') {
+                char escaped = i + 1 < end ? pointer[i + 1] : '\0';
+                if (escaped != '0' && escaped != '1') {
+                    return ParseError(
+                        ErrorCode::InvalidPointer,
+                        i,
+                        1,
+                        i + 1,
+                        pointer.substr(i, i + 1 < end ? 2 : 1)
+                    );
+                }
+                c = escaped == '0' ? '~' : '/';
+                i++;
+            }
+            step.key.push_back(c);
+        }
+        step.hash = std::hash<std::string_view>()(step.key);
+        step.index = parse_index(step.key);
+        path.m_steps.push_back(std::move(step));
+
+        if (end == pointer.size()) {
+            return path;
+        }
+        begin = end + 1;
+    }
+}
+
+const JsonValue* JsonValue::find(const Path& path) const {
+    return follow(*this, path, 0);
+}
+
+std::optional<JsonValue>
+JsonValue::with(const Path& path, JsonValue value) const {
+    // The containers the path goes through, outermost first
+    std::vector<const JsonValue*> chain;
+    const JsonValue* current = this;
+    for (size_t i = 0; i < path.size(); i++) {
+        const Path::Step& step = path.steps()[i];
+        bool last = i + 1 == path.size();
+        chain.push_back(current);
+        if (current->is_object()) {
+            const JsonObject& object = current->to_object();
+            auto member = object.find(step.key, step.hash);
+            if (member != object.end()) {
+                current = &member->second;
+            } else if (!last) {
+                return std::nullopt;
+            }
+        } else if (current->is_array()) {
+            const JsonArray& array = current->to_array();
+            if (step.index < array.size()) {
+                current = &array[step.index];
+            } else if (!last || (step.index != array.size() && step.key != "-")) {
+                return std::nullopt;
+            }
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    // Copied from the innermost out, each copy taking the one inside it
+    for (size_t i = chain.size(); i-- > 0;) {
+        const JsonValue& container = *chain[i];
+        const Path::Step& step = path.steps()[i];
+        if (container.is_object()) {
+            JsonObject object = container.to_object();
+            object.insert_or_assign(JsonKey(step.key), std::move(value));
+            value = container.is_shared() ? shared_object(std::move(object))
+                                          : JsonValue(std::move(object));
+        } else {
+            JsonArray array = container.to_array();
+            if (step.index < array.size()) {
+                array[step.index] = std::move(value);
+            } else {
+                array.push_back(std::move(value));
+            }
+            value = container.is_shared() ? shared_array(std::move(array))
+                                          : JsonValue(std::move(array));
+        }
+    }
+    return value;
+}
+
+Result<size_t, ParseError> Parser::parse_paths(
+    std::string_view json,
+    const std::vector<Path>& paths,
+    std::vector<std::optional<JsonValue>>& values
+) {
+    values.assign(paths.size(), std::nullopt);
+    if (paths.empty()) {
+        return size_t(0);
+    }
+
+    m_member_stack.clear();
+    m_element_stack.clear();
+    m_container_stack.clear();
+
+    ::priv::brace::StringScope strings(
+        m_strings,
+        m_resource,
+        m_shared_values && m_intern_strings
+    );
+    DomBuilder builder(
+        m_resource,
+        m_member_stack,
+        m_element_stack,
+        m_container_stack,
+        nullptr,
+        m_shared_values,
+        strings.table()
+    );
+    PathFinder finder(paths, values, builder);
+    auto parsed = run_sax(json, false, finder);
+    // The finder cancels parsing as soon as it is done
+    if (parsed.is_err() && !finder.stopped()) {
+        m_member_stack.clear();
+        m_element_stack.clear();
+        m_container_stack.clear();
+        return std::move(parsed).unwrap_err();
+    }
+    return finder.found();
+}
+
+}  // namespace brace
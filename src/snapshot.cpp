@@ -0,0 +1,573 @@
+#include <brace/path.h>
+#include <brace/snapshot.h>
+#include <priv/brace/mapped_file.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace brace {
+
+// A snapshot is a sequence of 8-byte words. The first three are a header:
+//
+//     "BRACESNP"
+//     uint32_t version, uint32_t slot of the root value
+//     uint64_t size of the snapshot in bytes
+//
+// Values follow, each starting on a word with a head word that holds its
+// tag in the low byte and, for strings, arrays and objects, their size in
+// the others. Values are referred to by 32-bit slots: the offset of the
+// value in words, or with the top bit set, an integer of 31 bits stored in
+// the slot itself.
+//
+//     null, false, true  the head only, stored once and shared
+//     numbers            the head, then the number in a word of its own,
+//                        stored once
+//     strings            the head, then the bytes
+//     arrays             the head, then the slot of each element
+//     objects            the head, then the offset of each member's key
+//                        and its value's slot, in order. Objects larger
+//                        than JsonObject::index_threshold then list the
+//                        positions of their members sorted by key.
+//
+// Containers go before their contents, so walking down a snapshot reads it
+// front to back. Everything is padded to a whole number of words.
+
+namespace {
+
+constexpr char magic[8] = {'B', 'R', 'A', 'C', 'E', 'S', 'N', 'P'};
+constexpr uint32_t version = 1;
+constexpr size_t word_size = 8;
+constexpr size_t header_words = 3;
+// Slots holding an integer rather than an offset
+constexpr uint32_t inline_flag = uint32_t(1) << 31;
+constexpr int64_t max_inline = (int64_t(1) << 30) - 1;
+constexpr int64_t min_inline = -(int64_t(1) << 30);
+// Offsets must fit in the other 31 bits
+constexpr size_t max_snapshot_size = (size_t(1) << 31) * word_size;
+
+enum class Tag : uint8_t {
+    Null,
+    False,
+    True,
+    Int64,
+    Uint64,
+    Double,
+    String,
+    Array,
+    Object,
+};
+
+uint64_t make_head(Tag tag, size_t size = 0) {
+    return static_cast<uint64_t>(size) << 8 | static_cast<uint8_t>(tag);
+}
+
+Tag tag_of(uint64_t head) {
+    return static_cast<Tag>(head & 0xff);
+}
+
+size_t size_of(uint64_t head) {
+    return static_cast<size_t>(head >> 8);
+}
+
+size_t words_for(size_t bytes) {
+    return (bytes + word_size - 1) / word_size;
+}
+
+bool is_inline(uint32_t slot) {
+    return slot & inline_flag;
+}
+
+int64_t inline_value(uint32_t slot) {
+    int64_t n = slot & ~inline_flag;
+    // Sign extended from 31 bits
+    return n > max_inline ? n - (int64_t(1) << 31) : n;
+}
+
+// Snapshots may be mapped at any address, so they are read with memcpy
+// rather than through pointers that may not be aligned. Only the header is
+// checked up front, so everything else is checked as it is read: what lies
+// outside of a damaged snapshot reads as zeros, which is a null head.
+template<typename T>
+T load(std::string_view bytes, size_t offset) {
+    T value {};
+    if (offset <= bytes.size() && sizeof(T) <= bytes.size() - offset) {
+        std::memcpy(&value, bytes.data() + offset, sizeof(T));
+    }
+    return value;
+}
+
+// Empty if the string does not fit in the snapshot
+std::string_view load_string(std::string_view bytes, uint32_t offset) {
+    size_t at = size_t(offset) * word_size + word_size;
+    size_t size = size_of(load<uint64_t>(bytes, at - word_size));
+    if (at > bytes.size() || size > bytes.size() - at) {
+        return bytes.substr(0, 0);
+    }
+    return bytes.substr(at, size);
+}
+
+ParseError invalid_snapshot(std::string_view reason) {
+    return ParseError(ErrorCode::InvalidSnapshot, 0, 0, 0, reason);
+}
+
+// Lays values out in a snapshot. Keys, strings and numbers are stored once,
+// looked up by their contents, which stay in the encoded value meanwhile.
+class Encoder {
+  public:
+    Result<std::string, ParseError> encode(const JsonValue& value) {
+        m_out.assign(header_words * word_size, '\0');
+        uint32_t root = write_value(value);
+        if (m_too_large) {
+            return ParseError(
+                ErrorCode::InputTooLarge,
+                0,
+                0,
+                0,
+                "snapshots are limited to 16 GiB"
+            );
+        }
+
+        std::memcpy(&m_out[0], magic, sizeof(magic));
+        std::memcpy(&m_out[8], &version, sizeof(version));
+        std::memcpy(&m_out[12], &root, sizeof(root));
+        uint64_t size = m_out.size();
+        std::memcpy(&m_out[16], &size, sizeof(size));
+        return std::move(m_out);
+    }
+
+  private:
+    std::string m_out;
+    std::unordered_map<std::string_view, uint32_t> m_strings;
+    // By their bits, for each kind of number
+    std::unordered_map<uint64_t, uint32_t> m_numbers[3];
+    // Offsets of null, false and true once written
+    uint32_t m_constants[3] {};
+    bool m_too_large {false};
+
+    // Appends `words` zeroed words, returning the offset of the first
+    uint32_t append(size_t words) {
+        size_t offset = m_out.size() / word_size;
+        if ((offset + words) * word_size > max_snapshot_size) {
+            m_too_large = true;
+            return 0;
+        }
+        m_out.resize(m_out.size() + words * word_size, '\0');
+        return static_cast<uint32_t>(offset);
+    }
+
+    template<typename T>
+    void put(size_t offset, T value) {
+        std::memcpy(&m_out[offset], &value, sizeof(T));
+    }
+
+    uint32_t write_value(const JsonValue& value) {
+        if (m_too_large) {
+            return 0;
+        }
+        switch (value.type()) {
+            case JsonType::Null: return write_constant(Tag::Null);
+            case JsonType::Bool:
+                return write_constant(bool(value) ? Tag::True : Tag::False);
+            case JsonType::Int64: {
+                int64_t n = value.to_int64();
+                if (n >= min_inline && n <= max_inline) {
+                    return inline_flag | (static_cast<uint32_t>(n) & ~inline_flag);
+                }
+                return write_number(Tag::Int64, n);
+            }
+            case JsonType::Uint64:
+                return write_number(Tag::Uint64, value.to_uint64());
+            case JsonType::Double:
+                return write_number(Tag::Double, value.to_double());
+            case JsonType::String: return write_string(value.to_string_view());
+            case JsonType::Array: return write_array(value.to_array());
+            case JsonType::Object: return write_object(value.to_object());
+        }
+        return 0;
+    }
+
+    uint32_t write_constant(Tag tag) {
+        uint32_t& offset = m_constants[static_cast<uint8_t>(tag)];
+        if (offset == 0) {
+            offset = append(1);
+            if (!m_too_large) {
+                put(size_t(offset) * word_size, make_head(tag));
+            }
+        }
+        return offset;
+    }
+
+    template<typename T>
+    uint32_t write_number(Tag tag, T number) {
+        uint64_t bits;
+        std::memcpy(&bits, &number, sizeof(bits));
+        auto& known = m_numbers[static_cast<uint8_t>(tag) - uint8_t(Tag::Int64)];
+        auto [entry, added] = known.emplace(bits, 0);
+        if (!added) {
+            return entry->second;
+        }
+        uint32_t offset = append(2);
+        if (!m_too_large) {
+            put(size_t(offset) * word_size, make_head(tag));
+            put(size_t(offset) * word_size + word_size, number);
+        }
+        entry->second = offset;
+        return offset;
+    }
+
+    uint32_t write_string(std::string_view s) {
+        auto known = m_strings.find(s);
+        if (known != m_strings.end()) {
+            return known->second;
+        }
+        uint32_t offset = append(1 + words_for(s.size()));
+        if (!m_too_large) {
+            size_t at = size_t(offset) * word_size;
+            put(at, make_head(Tag::String, s.size()));
+            std::memcpy(&m_out[at + word_size], s.data(), s.size());
+            m_strings.emplace(s, offset);
+        }
+        return offset;
+    }
+
+    uint32_t write_array(const JsonArray& array) {
+        uint32_t offset = append(1 + words_for(array.size() * sizeof(uint32_t)));
+        if (m_too_large) {
+            return 0;
+        }
+        size_t at = size_t(offset) * word_size;
+        put(at, make_head(Tag::Array, array.size()));
+        for (size_t i = 0; i < array.size(); i++) {
+            uint32_t element = write_value(array[i]);
+            put(at + word_size + i * sizeof(uint32_t), element);
+        }
+        return offset;
+    }
+
+    uint32_t write_object(const JsonObject& object) {
+        size_t size = object.size();
+        bool sorted = size > JsonObject::index_threshold;
+        size_t slots = size * 2 + (sorted ? size : 0);
+        uint32_t offset = append(1 + words_for(slots * sizeof(uint32_t)));
+        if (m_too_large) {
+            return 0;
+        }
+        size_t at = size_t(offset) * word_size;
+        put(at, make_head(Tag::Object, size));
+
+        std::vector<std::string_view> keys;
+        keys.reserve(size);
+        size_t slot = at + word_size;
+        for (const auto& [key, value] : object) {
+            keys.push_back(key);
+            put(slot, write_string(key));
+            put(slot + sizeof(uint32_t), write_value(value));
+            slot += 2 * sizeof(uint32_t);
+        }
+        if (sorted) {
+            std::vector<uint32_t> order(size);
+            for (size_t i = 0; i < size; i++) {
+                order[i] = static_cast<uint32_t>(i);
+            }
+            std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+                return keys[a] < keys[b];
+            });
+            for (uint32_t position : order) {
+                put(slot, position);
+                slot += sizeof(uint32_t);
+            }
+        }
+        return offset;
+    }
+};
+
+}  // namespace
+
+Snapshot::Snapshot(Snapshot&&) noexcept = default;
+Snapshot& Snapshot::operator=(Snapshot&&) noexcept = default;
+Snapshot::~Snapshot() = default;
+
+Result<std::string, ParseError> Snapshot::encode(const JsonValue& value) {
+    return Encoder().encode(value);
+}
+
+Result<Unit, ParseError>
+Snapshot::write(const JsonValue& value, const std::string& path) {
+    TRY_ASSIGN_MOVE(bytes, encode(value));
+
+    // Written next to the file and moved over it once complete, so that
+    // processes that have the previous snapshot mapped keep reading it.
+    // The name is unique to this write, writers of the same snapshot in
+    // other threads or processes each replace it with a whole file.
+    static std::atomic<uint64_t> writes {0};
+    std::random_device random;
+    std::string temporary = path + "." + std::to_string(random()) + "_"
+        + std::to_string(writes.fetch_add(1, std::memory_order_relaxed))
+        + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        file.close();
+        if (!file) {
+            std::remove(temporary.c_str());
+            return ParseError(ErrorCode::Io, 0, 0, 0, "Could not write " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        // Renaming does not replace existing files everywhere
+        std::remove(path.c_str());
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+            std::remove(temporary.c_str());
+            return ParseError(ErrorCode::Io, 0, 0, 0, "Could not replace " + path);
+        }
+    }
+    return Unit {};
+}
+
+Result<Snapshot, ParseError> Snapshot::open(const std::string& path) {
+    Snapshot snapshot;
+    snapshot.m_file = std::make_unique<::priv::brace::MappedFile>();
+    // Only the pages that are looked at are read in
+    TRY(snapshot.m_file->open(path, false));
+    snapshot.m_bytes = snapshot.m_file->contents();
+    return check(std::move(snapshot));
+}
+
+Result<Snapshot, ParseError> Snapshot::view(std::string_view bytes) {
+    Snapshot snapshot;
+    snapshot.m_bytes = bytes;
+    return check(std::move(snapshot));
+}
+
+Result<Snapshot, ParseError> Snapshot::check(Snapshot&& snapshot) {
+    std::string_view bytes = snapshot.m_bytes;
+    if (bytes.size() < header_words * word_size
+        || std::memcmp(bytes.data(), magic, sizeof(magic)) != 0) {
+        return invalid_snapshot("not a snapshot");
+    } else if (load<uint32_t>(bytes, 8) != version) {
+        return invalid_snapshot("unsupported version or byte order");
+    } else if (load<uint64_t>(bytes, 16) != bytes.size()) {
+        return invalid_snapshot("truncated");
+    }
+
+    snapshot.m_root = load<uint32_t>(bytes, 12);
+    if (!is_inline(snapshot.m_root)
+        && (snapshot.m_root < header_words
+            || size_t(snapshot.m_root) * word_size >= bytes.size())) {
+        return invalid_snapshot("root out of bounds");
+    }
+    return std::move(snapshot);
+}
+
+SnapshotValue Snapshot::root() const {
+    return SnapshotValue(m_bytes, m_root);
+}
+
+uint64_t SnapshotValue::head() const {
+    if (is_inline(m_slot)) {
+        return make_head(Tag::Int64);
+    }
+    return load<uint64_t>(m_bytes, size_t(m_slot) * word_size);
+}
+
+JsonType SnapshotValue::type() const {
+    switch (tag_of(head())) {
+        case Tag::Null: break;
+        case Tag::False:
+        case Tag::True: return JsonType::Bool;
+        case Tag::Int64: return JsonType::Int64;
+        case Tag::Uint64: return JsonType::Uint64;
+        case Tag::Double: return JsonType::Double;
+        case Tag::String: return JsonType::String;
+        case Tag::Array: return JsonType::Array;
+        case Tag::Object: return JsonType::Object;
+    }
+    return JsonType::Null;
+}
+
+std::string_view SnapshotValue::to_string_view() const {
+    assert(is_string() && "SnapshotValue is not a string");
+    return load_string(m_bytes, m_slot);
+}
+
+JsonValue SnapshotValue::get_scalar() const {
+    if (is_inline(m_slot)) {
+        return JsonValue(inline_value(m_slot));
+    }
+    size_t value = size_t(m_slot) * word_size + word_size;
+    switch (tag_of(head())) {
+        case Tag::False: return JsonValue(false);
+        case Tag::True: return JsonValue(true);
+        case Tag::Int64: return JsonValue(load<int64_t>(m_bytes, value));
+        case Tag::Uint64: return JsonValue(load<uint64_t>(m_bytes, value));
+        case Tag::Double: return JsonValue(load<double>(m_bytes, value));
+        default: return JsonValue();
+    }
+}
+
+JsonValue SnapshotValue::get() const {
+    return materialize(0);
+}
+
+JsonValue SnapshotValue::materialize(size_t depth) const {
+    // Contents go after their container, anything else is damage that
+    // could lead back to where it started
+    auto nested = [&](uint32_t slot) {
+        SnapshotValue value(m_bytes, slot);
+        bool container = value.is_array() || value.is_object();
+        if (container && (slot <= m_slot || depth + 1 >= default_max_depth)) {
+            return JsonValue();
+        }
+        return value.materialize(depth + 1);
+    };
+
+    size_t slots = size_t(m_slot) * word_size + word_size;
+    switch (type()) {
+        case JsonType::String: {
+            std::string_view s = to_string_view();
+            return JsonValue(s, std::pmr::get_default_resource());
+        }
+        case JsonType::Array: {
+            JsonArray array;
+            array.reserve(size());
+            for (size_t i = 0; i < size(); i++) {
+                uint32_t element =
+                    load<uint32_t>(m_bytes, slots + i * sizeof(uint32_t));
+                array.push_back(nested(element));
+            }
+            return JsonValue(std::move(array));
+        }
+        case JsonType::Object: {
+            JsonObject object;
+            object.reserve(size());
+            for (size_t i = 0; i < size(); i++) {
+                size_t slot = slots + i * 2 * sizeof(uint32_t);
+                uint32_t key = load<uint32_t>(m_bytes, slot);
+                uint32_t value = load<uint32_t>(m_bytes, slot + sizeof(uint32_t));
+                object.insert_or_assign(
+                    JsonKey(load_string(m_bytes, key)),
+                    nested(value)
+                );
+            }
+            return JsonValue(std::move(object));
+        }
+        default: return get_scalar();
+    }
+}
+
+size_t SnapshotValue::size() const {
+    uint64_t h = head();
+    Tag tag = tag_of(h);
+    if (tag != Tag::Array && tag != Tag::Object) {
+        return 0;
+    }
+
+    // Damaged containers whose slots do not fit in the snapshot are empty
+    size_t size = size_of(h);
+    size_t slot_bytes = sizeof(uint32_t);
+    if (tag == Tag::Object) {
+        slot_bytes *= size > JsonObject::index_threshold ? 3 : 2;
+    }
+    size_t slots = size_t(m_slot) * word_size + word_size;
+    size_t room = slots <= m_bytes.size() ? m_bytes.size() - slots : 0;
+    return size <= room / slot_bytes ? size : 0;
+}
+
+uint32_t SnapshotValue::find_member(std::string_view key) const {
+    assert(is_object() && "SnapshotValue is not an object");
+    size_t size = this->size();
+    size_t slots = size_t(m_slot) * word_size + word_size;
+    auto key_at = [&](size_t position) {
+        uint32_t offset =
+            load<uint32_t>(m_bytes, slots + position * 2 * sizeof(uint32_t));
+        return load_string(m_bytes, offset);
+    };
+    auto value_at = [&](size_t position) {
+        return load<uint32_t>(
+            m_bytes,
+            slots + position * 2 * sizeof(uint32_t) + sizeof(uint32_t)
+        );
+    };
+
+    if (size <= JsonObject::index_threshold) {
+        for (size_t i = 0; i < size; i++) {
+            if (key_at(i) == key) {
+                return value_at(i);
+            }
+        }
+        return 0;
+    }
+
+    // Binary search over the positions sorted by key
+    size_t order = slots + size * 2 * sizeof(uint32_t);
+    size_t low = 0;
+    size_t high = size;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        uint32_t position =
+            load<uint32_t>(m_bytes, order + middle * sizeof(uint32_t));
+        if (position >= size) {
+            return 0;  // Damaged
+        }
+        std::string_view candidate = key_at(position);
+        if (candidate == key) {
+            return value_at(position);
+        } else if (candidate < key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return 0;
+}
+
+bool SnapshotValue::contains(std::string_view key) const {
+    return is_object() && find_member(key) != 0;
+}
+
+SnapshotValue SnapshotValue::operator[](std::string_view key) const {
+    uint32_t slot = find_member(key);
+    if (slot == 0) {
+        throw std::out_of_range("SnapshotValue: no such key");
+    }
+    return SnapshotValue(m_bytes, slot);
+}
+
+SnapshotValue SnapshotValue::operator[](size_t index) const {
+    assert(is_array() && "SnapshotValue is not an array");
+    if (index >= size()) {
+        throw std::out_of_range("SnapshotValue: index out of bounds");
+    }
+    size_t slot = size_t(m_slot) * word_size + word_size
+        + index * sizeof(uint32_t);
+    return SnapshotValue(m_bytes, load<uint32_t>(m_bytes, slot));
+}
+
+std::optional<SnapshotValue> SnapshotValue::find(const Path& path) const {
+    SnapshotValue current = *this;
+    for (const Path::Step& step : path.steps()) {
+        if (current.is_object()) {
+            uint32_t slot = current.find_member(step.key);
+            if (slot == 0) {
+                return std::nullopt;
+            }
+            current.m_slot = slot;
+        } else if (current.is_array() && step.index < current.size()) {
+            current = current[step.index];
+        } else {
+            return std::nullopt;
+        }
+    }
+    return current;
+}
+
+}  // namespace brace
@@ -0,0 +1,278 @@
+#include <brace/stream.h>
+#include <priv/brace/dom_builder.h>
+
+namespace brace {
+
+using Token = ::priv::brace::Token;
+using TokenType = ::priv::brace::TokenType;
+using DomBuilder = ::priv::brace::DomBuilder;
+
+namespace {
+
+// The furthest the tokenizer looks past the byte it reports a malformed
+// token at, for the second half of a surrogate pair escape
+constexpr size_t max_lookahead = 12;
+
+}  // namespace
+
+Result<Unit, ParseError> StreamParser::feed(const char* data, size_t size) {
+    if (m_error) {
+        return *m_error;
+    }
+
+    // Strings are the only tokens that grow long, so one cut off by the
+    // last chunk is not scanned again until a chunk could end it
+    m_buffer.append(data, size);
+    if (m_in_string && !scan_string()) {
+        return Unit {};
+    }
+
+    auto result = consume(false);
+    if (result.is_err()) {
+        m_error = result.unwrap_err();
+    }
+    return result;
+}
+
+Result<JsonValue, ParseError> StreamParser::finish() {
+    if (m_error) {
+        return *m_error;
+    }
+
+    auto result = consume(true);
+    if (result.is_err()) {
+        m_error = result.unwrap_err();
+        return *m_error;
+    }
+    if (m_expect != Expect::Done) {
+        m_error = error_at(m_buffer.size(), ErrorCode::UnexpectedEnd);
+        return *m_error;
+    }
+
+    JsonValue root = std::move(m_root);
+    reset();
+    return root;
+}
+
+void StreamParser::reset() {
+    m_buffer.clear();
+    m_offset = 0;
+    m_line = 1;
+    m_column = 1;
+    m_expect = Expect::Value;
+    m_in_string = false;
+    m_string_scanned = 0;
+    m_string_escape = false;
+    m_error.reset();
+    m_root = JsonValue();
+    m_member_stack.clear();
+    m_element_stack.clear();
+    m_container_stack.clear();
+    m_count_stack.clear();
+}
+
+Result<Unit, ParseError> StreamParser::consume(bool final) {
+    DomBuilder builder(
+        m_resource,
+        m_member_stack,
+        m_element_stack,
+        m_container_stack
+    );
+
+    m_tokenizer.reset(m_buffer);
+    size_t consumed = 0;
+    while (true) {
+        auto result = m_tokenizer.next_token(m_buffer);
+        size_t end = m_tokenizer.position();
+
+        // A token that reaches the end of the buffer may go on in the next
+        // chunk, and one found malformed close to it may only be missing
+        // what follows. Both are scanned again once more input arrives.
+        if (!final
+            && (result.is_ok() ? end == m_buffer.size()
+                               : end + max_lookahead >= m_buffer.size())) {
+            break;
+        }
+
+        if (result.is_err()) {
+            const auto& err = result.unwrap_err();
+            return error_at(err.offset(), err.code(), err.detail());
+        }
+        const Token& token = result.unwrap_ok();
+        if (token.type == TokenType::Eof) {
+            consumed = end;
+            break;
+        }
+        TRY(process(token, builder));
+        consumed = end;
+    }
+
+    discard(consumed);
+    size_t pending = m_buffer.find_first_not_of(" \t\n\r");
+    m_in_string = pending != std::string::npos && m_buffer[pending] == '"';
+    m_string_scanned = pending + 1;
+    m_string_escape = false;
+    return Unit {};
+}
+
+Result<Unit, ParseError>
+StreamParser::process(const Token& token, DomBuilder& builder) {
+    switch (m_expect) {
+        case Expect::Value:
+        case Expect::ValueOrClose:
+            if (token.type == TokenType::RightBracket
+                && m_expect == Expect::ValueOrClose) {
+                close(builder);
+                return Unit {};
+            }
+            return value(token, builder);
+        case Expect::Key:
+        case Expect::KeyOrClose:
+            if (token.type == TokenType::StringLiteral) {
+                builder.on_key(decode_string(token));
+                m_expect = Expect::Colon;
+            } else if (token.type == TokenType::RightBrace
+                       && m_expect == Expect::KeyOrClose) {
+                close(builder);
+            } else {
+                return error_at(token.offset, ErrorCode::ExpectedKey);
+            }
+            return Unit {};
+        case Expect::Colon:
+            if (token.type != TokenType::Colon) {
+                return error_at(token.offset, ErrorCode::ExpectedColon);
+            }
+            m_expect = Expect::Value;
+            return Unit {};
+        case Expect::CommaOrClose: {
+            bool in_object = m_container_stack.back();
+            if (token.type == TokenType::Comma) {
+                // A trailing comma may go before the close, like in
+                // Parser::parse()
+                m_expect = in_object ? Expect::KeyOrClose : Expect::ValueOrClose;
+            } else if (token.type
+                       == (in_object ? TokenType::RightBrace
+                                     : TokenType::RightBracket)) {
+                close(builder);
+            } else {
+                return error_at(
+                    token.offset,
+                    in_object ? ErrorCode::ExpectedCommaOrBrace
+                              : ErrorCode::ExpectedCommaOrBracket
+                );
+            }
+            return Unit {};
+        }
+        case Expect::Done: return Unit {};
+    }
+    return Unit {};
+}
+
+Result<Unit, ParseError>
+StreamParser::value(const Token& token, DomBuilder& builder) {
+    bool opens = token.type == TokenType::LeftBrace
+        || token.type == TokenType::LeftBracket;
+    if (opens && m_count_stack.size() >= m_max_depth) {
+        return error_at(token.offset, ErrorCode::DepthExceeded);
+    }
+
+    if (token.type == TokenType::LeftBrace) {
+        builder.on_start_object();
+        m_count_stack.push_back(0);
+        m_expect = Expect::KeyOrClose;
+        return Unit {};
+    } else if (token.type == TokenType::LeftBracket) {
+        builder.on_start_array();
+        m_count_stack.push_back(0);
+        m_expect = Expect::ValueOrClose;
+        return Unit {};
+    }
+
+    if (token.type == TokenType::StringLiteral) {
+        builder.on_string(decode_string(token));
+    } else if (token.type == TokenType::NumberLiteral) {
+        ::priv::brace::Number number;
+        if (!::priv::brace::parse_number(token, number)) {
+            return error_at(token.offset, ErrorCode::NumberOutOfRange, token.lexeme);
+        }
+        switch (number.kind) {
+            case ::priv::brace::NumberKind::Int64:
+                builder.on_int64(number.int64);
+                break;
+            case ::priv::brace::NumberKind::Uint64:
+                builder.on_uint64(number.uint64);
+                break;
+            default: builder.on_double(number.number); break;
+        }
+    } else if (token.type == TokenType::Keyword && token.lexeme == "null") {
+        builder.on_null();
+    } else if (token.type == TokenType::Keyword
+               && (token.lexeme == "true" || token.lexeme == "false")) {
+        builder.on_bool(token.lexeme == "true");
+    } else {
+        return error_at(token.offset, ErrorCode::UnexpectedToken, token.lexeme);
+    }
+
+    end_value(builder);
+    return Unit {};
+}
+
+void StreamParser::close(DomBuilder& builder) {
+    size_t count = m_count_stack.back();
+    m_count_stack.pop_back();
+    if (m_container_stack.back()) {
+        builder.on_end_object(count);
+    } else {
+        builder.on_end_array(count);
+    }
+    end_value(builder);
+}
+
+void StreamParser::end_value(DomBuilder& builder) {
+    if (m_container_stack.empty()) {
+        m_root = builder.take_root();
+        m_expect = Expect::Done;
+        return;
+    }
+    m_count_stack.back()++;
+    m_expect = Expect::CommaOrClose;
+}
+
+bool StreamParser::scan_string() {
+    size_t i = m_string_scanned;
+    for (; i < m_buffer.size(); i++) {
+        char c = m_buffer[i];
+        // Line feeds are not allowed in strings, the tokenizer reports them
+        if (c == '\n' || (c == '"' && !m_string_escape)) {
+            return true;
+        }
+        m_string_escape = c == '\\' && !m_string_escape;
+    }
+    m_string_scanned = i;
+    return false;
+}
+
+void StreamParser::discard(size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (m_buffer[i] == '\n') {
+            m_line++;
+            m_column = 1;
+        } else {
+            m_column++;
+        }
+    }
+    m_buffer.erase(0, size);
+    m_offset += size;
+}
+
+std::string_view StreamParser::decode_string(const Token& token) {
+    // String literals without escapes are used straight from the input
+    if (!token.has_escapes) {
+        return token.lexeme;
+    }
+    m_scratch.resize(token.lexeme.size());
+    m_scratch.resize(::priv::brace::unescape(token.lexeme, m_scratch.data()));
+    return m_scratch;
+}
+
+}  // namespace brace
@@ -0,0 +1,103 @@
+#include <priv/brace/stats.h>
+#include <priv/brace/string_table.h>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace priv::brace {
+
+// Smallest table built, in slots
+static constexpr size_t min_table_size = 64;
+
+void StringTable::reset(std::pmr::memory_resource* resource, bool shared) {
+    m_resource = resource;
+    m_shared = shared;
+    if (m_size) {
+        // Drops the table's references to shared strings
+        for (Slot& slot : m_slots) {
+            slot.value = JsonValue();
+        }
+        m_size = 0;
+    }
+}
+
+StringTable::JsonValue StringTable::intern(std::string_view s) {
+    if (s.size() <= JsonValue::max_inline_size || s.size() > max_string_size) {
+        return store(s);
+    }
+    if (m_slots.empty() || (m_size * 2 >= m_slots.size() && m_size < max_strings)) {
+        grow();
+    }
+
+    size_t hash = std::hash<std::string_view>()(s);
+    size_t mask = m_slots.size() - 1;
+    size_t slot = hash & mask;
+    for (; !m_slots[slot].value.is_null(); slot = (slot + 1) & mask) {
+        const Slot& entry = m_slots[slot];
+        if (entry.hash == hash && entry.value.string_view() == s) {
+            return refer(entry.value);
+        }
+    }
+    if (m_size == max_strings) {
+        return store(s);
+    }
+
+    JsonValue value;
+    if (m_shared) {
+        value = JsonValue::shared_string(s, m_resource);
+    } else {
+        using StringRep = JsonValue::StringRep;
+        void* storage = m_resource->allocate(
+            sizeof(StringRep) + s.size(),
+            alignof(StringRep)
+        );
+        count_allocation(sizeof(StringRep) + s.size());
+        StringRep* rep = new (storage) StringRep {nullptr, s.size()};
+        std::memcpy(rep->chars(), s.data(), s.size());
+        value.m_type = ::brace::JsonType::String;
+        value.m_string_size = JsonValue::interned_string;
+        value.store(rep);
+    }
+    m_slots[slot] = Slot {hash, std::move(value)};
+    m_size++;
+    return refer(m_slots[slot].value);
+}
+
+StringTable::JsonValue StringTable::store(std::string_view s) const {
+    if (m_shared) {
+        return JsonValue::shared_string(s, m_resource);
+    }
+    return JsonValue(s, m_resource);
+}
+
+StringTable::JsonValue StringTable::refer(const JsonValue& value) const {
+    if (m_shared) {
+        return value;  // Counts a reference
+    }
+    JsonValue reference;
+    std::memcpy(reference.m_data, value.m_data, sizeof(value.m_data));
+    reference.m_string_size = JsonValue::interned_string;
+    reference.m_type = ::brace::JsonType::String;
+    return reference;
+}
+
+void StringTable::grow() {
+    std::pmr::vector<Slot> slots(
+        std::max(m_slots.size() * 2, min_table_size),
+        m_slots.get_allocator()
+    );
+    size_t mask = slots.size() - 1;
+    for (Slot& entry : m_slots) {
+        if (!entry.value.is_null()) {
+            size_t slot = entry.hash & mask;
+            while (!slots[slot].value.is_null()) {
+                slot = (slot + 1) & mask;
+            }
+            slots[slot] = std::move(entry);
+        }
+    }
+    m_slots = std::move(slots);
+}
+
+}  // namespace priv::brace
@@ -0,0 +1,598 @@
+#include <priv/brace/structural_index.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define BRACE_INDEX_X86 1
+    #include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define BRACE_INDEX_NEON 1
+    #include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+    #define BRACE_TARGET_SSE42
+    #define BRACE_TARGET_AVX2
+#else
+    #define BRACE_TARGET_SSE42 __attribute__((target("sse4.2")))
+    #define BRACE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace priv::brace {
+
+namespace {
+
+constexpr size_t block_size = 64;
+
+struct BlockMasks {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t slash;
+    uint64_t whitespace;
+    uint64_t structural;
+};
+
+using ClassifyFn = void (*)(const char* block, BlockMasks& masks);
+
+[[maybe_unused]] void classify_scalar(const char* block, BlockMasks& masks) {
+    masks = BlockMasks {};
+    for (size_t i = 0; i < block_size; i++) {
+        uint64_t bit = uint64_t(1) << i;
+        switch (block[i]) {
+            case '"':
+                masks.quote |= bit;
+                break;
+            case '\\':
+                masks.backslash |= bit;
+                break;
+            case '/':
+                masks.slash |= bit;
+                break;
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r':
+                masks.whitespace |= bit;
+                break;
+            case '{':
+            case '}':
+            case '[':
+            case ']':
+            case ':':
+            case ',':
+                masks.structural |= bit;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+#if defined(BRACE_INDEX_X86)
+
+// Whitespace and structural characters are found with a table lookup on
+// the low nibble of each byte: a byte is whitespace if it equals its entry
+// in `whitespace_table`, and structural if it equals its entry in
+// `structural_table` once bit 5 is set, which turns '[' and ']' into '{'
+// and '}'. Bytes with the high bit set look up zero and never match. The
+// control characters 0x0c and 0x1a match as structural too, which is
+// harmless since they are invalid outside of strings anyway.
+    #define BRACE_WHITESPACE_TABLE \
+        ' ', 100, 100, 100, 17, 100, 113, 2, 100, '\t', '\n', 112, 100, '\r', \
+            100, 100
+    #define BRACE_STRUCTURAL_TABLE \
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, ':', '{', ',', '}', 0, 0
+
+BRACE_TARGET_SSE42 void classify_sse42(const char* block, BlockMasks& masks) {
+    const __m128i whitespace_table = _mm_setr_epi8(BRACE_WHITESPACE_TABLE);
+    const __m128i structural_table = _mm_setr_epi8(BRACE_STRUCTURAL_TABLE);
+
+    masks = BlockMasks {};
+    for (size_t i = 0; i < block_size; i += 16) {
+        __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+        __m128i whitespace =
+            _mm_cmpeq_epi8(chunk, _mm_shuffle_epi8(whitespace_table, chunk));
+        __m128i structural = _mm_cmpeq_epi8(
+            _mm_or_si128(chunk, _mm_set1_epi8(0x20)),
+            _mm_shuffle_epi8(structural_table, chunk)
+        );
+        __m128i quote = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'));
+        __m128i backslash = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'));
+        __m128i slash = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('/'));
+
+        masks.quote |= uint64_t(uint32_t(_mm_movemask_epi8(quote))) << i;
+        masks.backslash |= uint64_t(uint32_t(_mm_movemask_epi8(backslash)))
+            << i;
+        masks.slash |= uint64_t(uint32_t(_mm_movemask_epi8(slash))) << i;
+        masks.whitespace |= uint64_t(uint32_t(_mm_movemask_epi8(whitespace)))
+            << i;
+        masks.structural |= uint64_t(uint32_t(_mm_movemask_epi8(structural)))
+            << i;
+    }
+}
+
+BRACE_TARGET_AVX2 void classify_avx2(const char* block, BlockMasks& masks) {
+    const __m256i whitespace_table = _mm256_setr_epi8(
+        BRACE_WHITESPACE_TABLE,
+        BRACE_WHITESPACE_TABLE
+    );
+    const __m256i structural_table = _mm256_setr_epi8(
+        BRACE_STRUCTURAL_TABLE,
+        BRACE_STRUCTURAL_TABLE
+    );
+
+    masks = BlockMasks {};
+    for (size_t i = 0; i < block_size; i += 32) {
+        __m256i chunk =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+        __m256i whitespace = _mm256_cmpeq_epi8(
+            chunk,
+            _mm256_shuffle_epi8(whitespace_table, chunk)
+        );
+        __m256i structural = _mm256_cmpeq_epi8(
+            _mm256_or_si256(chunk, _mm256_set1_epi8(0x20)),
+            _mm256_shuffle_epi8(structural_table, chunk)
+        );
+        __m256i quote = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'));
+        __m256i backslash = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'));
+        __m256i slash = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('/'));
+
+        // A lambda would not inherit the target attribute
+        masks.quote |= uint64_t(uint32_t(_mm256_movemask_epi8(quote))) << i;
+        masks.backslash |= uint64_t(uint32_t(_mm256_movemask_epi8(backslash)))
+            << i;
+        masks.slash |= uint64_t(uint32_t(_mm256_movemask_epi8(slash))) << i;
+        masks.whitespace |=
+            uint64_t(uint32_t(_mm256_movemask_epi8(whitespace))) << i;
+        masks.structural |=
+            uint64_t(uint32_t(_mm256_movemask_epi8(structural))) << i;
+    }
+}
+
+    #if defined(_MSC_VER) && !defined(__clang__)
+bool cpu_supports(bool avx2) {
+    int info[4];
+    __cpuid(info, 0);
+    int max_leaf = info[0];
+    __cpuid(info, 1);
+    bool has_sse42 = (info[2] & (1 << 20)) != 0;
+    if (!avx2) {
+        return has_sse42;
+    }
+    bool has_osxsave = (info[2] & (1 << 27)) != 0;
+    bool has_avx = (info[2] & (1 << 28)) != 0;
+    // The OS has to save the upper halves of the ymm registers
+    if (max_leaf < 7 || !has_osxsave || !has_avx
+        || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+}
+    #else
+bool cpu_supports(bool avx2) {
+    __builtin_cpu_init();
+    return avx2 ? __builtin_cpu_supports("avx2")
+                : __builtin_cpu_supports("sse4.2");
+}
+    #endif
+
+#elif defined(BRACE_INDEX_NEON)
+
+// NEON is mandatory on AArch64, so this kernel needs no runtime check. It
+// uses the same nibble tables as the x86 kernels.
+void classify_neon(const char* block, BlockMasks& masks) {
+    const uint8x16_t whitespace_table = {
+        ' ', 100, 100, 100, 17, 100, 113, 2,
+        100, '\t', '\n', 112, 100, '\r', 100, 100,
+    };
+    const uint8x16_t structural_table = {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, ':', '{', ',', '}', 0, 0,
+    };
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(block);
+
+    // Packs the 0x00/0xff lanes of four comparisons into a 64-bit mask
+    auto bits = [](const uint8x16_t (&m)[4]) {
+        const uint8x16_t weights = {
+            0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+            0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+        };
+        uint8x16_t sum0 =
+            vpaddq_u8(vandq_u8(m[0], weights), vandq_u8(m[1], weights));
+        uint8x16_t sum1 =
+            vpaddq_u8(vandq_u8(m[2], weights), vandq_u8(m[3], weights));
+        sum0 = vpaddq_u8(sum0, sum1);
+        sum0 = vpaddq_u8(sum0, sum0);
+        return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+    };
+
+    uint8x16_t quote[4], backslash[4], slash[4], whitespace[4], structural[4];
+    for (size_t i = 0; i < 4; i++) {
+        uint8x16_t chunk = vld1q_u8(bytes + i * 16);
+        uint8x16_t nibbles = vandq_u8(chunk, vdupq_n_u8(0x0f));
+        whitespace[i] = vceqq_u8(chunk, vqtbl1q_u8(whitespace_table, nibbles));
+        structural[i] = vceqq_u8(
+            vorrq_u8(chunk, vdupq_n_u8(0x20)),
+            vqtbl1q_u8(structural_table, nibbles)
+        );
+        quote[i] = vceqq_u8(chunk, vdupq_n_u8('"'));
+        backslash[i] = vceqq_u8(chunk, vdupq_n_u8('\\'));
+        slash[i] = vceqq_u8(chunk, vdupq_n_u8('/'));
+    }
+
+    masks.quote = bits(quote);
+    masks.backslash = bits(backslash);
+    masks.slash = bits(slash);
+    masks.whitespace = bits(whitespace);
+    masks.structural = bits(structural);
+}
+
+#endif
+
+struct Kernel {
+    ClassifyFn classify;
+    const char* name;
+};
+
+const Kernel& kernel() {
+    static const Kernel selected = []() -> Kernel {
+#if defined(BRACE_INDEX_X86)
+        if (cpu_supports(true)) {
+            return {classify_avx2, "avx2"};
+        } else if (cpu_supports(false)) {
+            return {classify_sse42, "sse4.2"};
+        }
+        return {classify_scalar, "scalar"};
+#elif defined(BRACE_INDEX_NEON)
+        return {classify_neon, "neon"};
+#else
+        return {classify_scalar, "scalar"};
+#endif
+    }();
+    return selected;
+}
+
+inline size_t trailing_zeros(uint64_t bits) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return index;
+#else
+    return static_cast<size_t>(__builtin_ctzll(bits));
+#endif
+}
+
+// Sets every bit that has an odd number of set bits at or below it, which
+// turns a mask of quotes into a mask of string openings and contents
+inline uint64_t prefix_xor(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+// Finds the characters escaped by a backslash: those that follow a run of
+// an odd number of backslashes. `prev_escaped` carries a run that ends on
+// an odd count across the block boundary.
+inline uint64_t find_escaped(uint64_t backslash, uint64_t& prev_escaped) {
+    constexpr uint64_t even_bits = 0x5555555555555555ULL;
+    constexpr uint64_t odd_bits = ~even_bits;
+
+    uint64_t start_edges = backslash & ~(backslash << 1);
+    uint64_t even_start_mask = even_bits ^ prev_escaped;
+    uint64_t even_starts = start_edges & even_start_mask;
+    uint64_t odd_starts = start_edges & ~even_start_mask;
+    uint64_t even_carries = backslash + even_starts;
+    uint64_t odd_carries = backslash + odd_starts;
+    bool ends_odd = odd_carries < backslash;
+    odd_carries |= prev_escaped;
+    prev_escaped = ends_odd ? 1 : 0;
+
+    uint64_t even_carry_ends = even_carries & ~backslash;
+    uint64_t odd_carry_ends = odd_carries & ~backslash;
+    return (even_carry_ends & odd_bits) | (odd_carry_ends & even_bits);
+}
+
+}  // namespace
+
+size_t
+find_string_delimiter(
+    std::string_view input,
+    size_t from,
+    bool& non_ascii,
+    bool padded
+) {
+    const char* data = input.data();
+    size_t size = input.size();
+    size_t i = from;
+
+#if defined(BRACE_INDEX_X86)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i newline = _mm_set1_epi8('\n');
+    // Padding past the end is loaded along with the last bytes and masked
+    // off, leaving nothing for the scalar loop
+    for (; padded ? i < size : i + 16 <= size; i += 16) {
+        __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(chunk, quote),
+                _mm_cmpeq_epi8(chunk, backslash)
+            ),
+            _mm_cmpeq_epi8(chunk, newline)
+        );
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+        uint32_t high = static_cast<uint32_t>(_mm_movemask_epi8(chunk));
+        if (size - i < 16) {
+            uint32_t valid = (uint32_t(1) << (size - i)) - 1;
+            mask &= valid;
+            high &= valid;
+        }
+        if (mask) {
+            size_t index = trailing_zeros(mask);
+            non_ascii |= (high & ((uint32_t(1) << index) - 1)) != 0;
+            return i + index;
+        }
+        non_ascii |= high != 0;
+    }
+#elif defined(BRACE_INDEX_NEON)
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(data + i));
+        uint8x16_t hits = vorrq_u8(
+            vorrq_u8(
+                vceqq_u8(chunk, vdupq_n_u8('"')),
+                vceqq_u8(chunk, vdupq_n_u8('\\'))
+            ),
+            vceqq_u8(chunk, vdupq_n_u8('\n'))
+        );
+        if (vmaxvq_u8(hits)) {
+            break;  // Pinpointed by the scalar loop
+        }
+        non_ascii |= vmaxvq_u8(chunk) >= 0x80;
+    }
+#endif
+
+    for (; i < size; i++) {
+        char c = data[i];
+        if (c == '"' || c == '\\' || c == '\n') {
+            return i;
+        }
+        non_ascii |= (static_cast<uint8_t>(c) & 0x80) != 0;
+    }
+    return size;
+}
+
+bool validate_utf8(std::string_view text) {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(text.data());
+    size_t size = text.size();
+    size_t i = 0;
+
+    while (i < size) {
+#if defined(BRACE_INDEX_X86)
+        while (i + 16 <= size
+               && _mm_movemask_epi8(_mm_loadu_si128(
+                      reinterpret_cast<const __m128i*>(data + i)
+                  )) == 0) {
+            i += 16;
+        }
+#elif defined(BRACE_INDEX_NEON)
+        while (i + 16 <= size && vmaxvq_u8(vld1q_u8(data + i)) < 0x80) {
+            i += 16;
+        }
+#endif
+        if (i >= size) {
+            break;
+        }
+
+        uint8_t lead = data[i];
+        if (lead < 0x80) {
+            i++;
+            continue;
+        }
+
+        size_t continuation;
+        uint32_t code_point;
+        if (lead >= 0xc2 && lead <= 0xdf) {
+            continuation = 1;
+            code_point = lead & 0x1f;
+        } else if ((lead & 0xf0) == 0xe0) {
+            continuation = 2;
+            code_point = lead & 0x0f;
+        } else if (lead >= 0xf0 && lead <= 0xf4) {
+            continuation = 3;
+            code_point = lead & 0x07;
+        } else {
+            return false;  // Continuation byte, overlong lead or past U+10FFFF
+        }
+
+        if (i + continuation >= size) {
+            return false;
+        }
+        for (size_t k = 1; k <= continuation; k++) {
+            uint8_t byte = data[i + k];
+            if ((byte & 0xc0) != 0x80) {
+                return false;
+            }
+            code_point = (code_point << 6) | (byte & 0x3f);
+        }
+
+        if (continuation == 2
+            && (code_point < 0x800
+                || (code_point >= 0xd800 && code_point <= 0xdfff))) {
+            return false;
+        } else if (continuation == 3
+                   && (code_point < 0x10000 || code_point > 0x10ffff)) {
+            return false;
+        }
+        i += continuation + 1;
+    }
+
+    return true;
+}
+
+size_t find_escape_char(std::string_view text, size_t from) {
+    const char* data = text.data();
+    size_t size = text.size();
+    size_t i = from;
+
+#if defined(BRACE_INDEX_X86)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i max_control = _mm_set1_epi8(0x1f);
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        // Bytes up to 0x1f are left unchanged by an unsigned minimum
+        __m128i control =
+            _mm_cmpeq_epi8(_mm_min_epu8(chunk, max_control), chunk);
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(chunk, quote),
+                _mm_cmpeq_epi8(chunk, backslash)
+            ),
+            control
+        );
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+        if (mask) {
+            return i + trailing_zeros(mask);
+        }
+    }
+#elif defined(BRACE_INDEX_NEON)
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(data + i));
+        uint8x16_t hits = vorrq_u8(
+            vorrq_u8(
+                vceqq_u8(chunk, vdupq_n_u8('"')),
+                vceqq_u8(chunk, vdupq_n_u8('\\'))
+            ),
+            vcltq_u8(chunk, vdupq_n_u8(0x20))
+        );
+        if (vmaxvq_u8(hits)) {
+            break;  // Pinpointed by the scalar loop
+        }
+    }
+#endif
+
+    for (; i < size; i++) {
+        uint8_t c = static_cast<uint8_t>(data[i]);
+        if (c == '"' || c == '\\' || c < 0x20) {
+            return i;
+        }
+    }
+    return size;
+}
+
+void StructuralIndexer::reset(size_t position, bool padded) {
+    m_size = 0;
+    m_position = position;
+    m_padded = padded;
+    m_prev_escaped = 0;
+    m_prev_in_string = 0;
+    m_prev_scalar = 0;
+}
+
+bool StructuralIndexer::scan(std::string_view input, size_t min_bytes) {
+    m_size = 0;
+    if (input.size() >= max_input_size) {
+        return false;
+    }
+
+    size_t blocks = (min_bytes + block_size - 1) / block_size;
+    size_t end = std::min(input.size(), m_position + blocks * block_size);
+    // At most one token starts at every byte
+    reserve(end - m_position + block_size);
+
+    while (m_position + block_size <= end) {
+        if (!scan_block(input.data() + m_position, m_position, block_size)) {
+            return false;
+        }
+        m_position += block_size;
+    }
+
+    if (m_position < end && m_padded) {
+        if (!scan_block(input.data() + m_position, m_position, end - m_position)) {
+            return false;
+        }
+        m_position = end;
+    } else if (m_position < end) {
+        // Pad the final partial block with whitespace, no token starts there
+        char block[block_size];
+        std::memset(block, ' ', block_size);
+        std::memcpy(block, input.data() + m_position, end - m_position);
+        if (!scan_block(block, m_position, block_size)) {
+            return false;
+        }
+        m_position = end;
+    }
+
+    return true;
+}
+
+bool StructuralIndexer::scan_all(std::string_view input) {
+    reset();
+    return scan(input, input.size());
+}
+
+const char* StructuralIndexer::implementation() {
+    return kernel().name;
+}
+
+void StructuralIndexer::reserve(size_t capacity) {
+    if (capacity > m_capacity) {
+        m_structurals.reset(new uint32_t[capacity]);
+        m_capacity = capacity;
+    }
+}
+
+bool StructuralIndexer::scan_block(
+    const char* block,
+    size_t offset,
+    size_t valid
+) {
+    BlockMasks masks;
+    kernel().classify(block, masks);
+    if (valid < block_size) {
+        // Whatever lies past the end reads as whitespace
+        uint64_t inside = (uint64_t(1) << valid) - 1;
+        masks.quote &= inside;
+        masks.backslash &= inside;
+        masks.slash &= inside;
+        masks.structural &= inside;
+        masks.whitespace |= ~inside;
+    }
+
+    uint64_t escaped = find_escaped(masks.backslash, m_prev_escaped);
+    uint64_t quotes = masks.quote & ~escaped;
+    // Opening quotes and string contents, but not closing quotes
+    uint64_t in_string = prefix_xor(quotes) ^ m_prev_in_string;
+    m_prev_in_string = uint64_t(int64_t(in_string) >> 63);
+    uint64_t outside = ~(in_string | quotes);
+
+    if (masks.slash & outside) {
+        return false;
+    }
+
+    uint64_t structural = masks.structural & outside;
+    uint64_t scalar = outside & ~(masks.structural | masks.whitespace);
+    uint64_t scalar_starts = scalar & ~((scalar << 1) | m_prev_scalar);
+    m_prev_scalar = scalar >> 63;
+
+    uint64_t starts = structural | (quotes & in_string) | scalar_starts;
+    uint32_t* out = m_structurals.get() + m_size;
+    while (starts) {
+        *out++ = static_cast<uint32_t>(offset + trailing_zeros(starts));
+        starts &= starts - 1;
+    }
+    m_size = out - m_structurals.get();
+
+    return true;
+}
+
+}  // namespace priv::brace
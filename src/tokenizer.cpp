@@ -1,31 +1,181 @@
 #include <priv/brace/tokenizer.h>
 
-#include <unordered_set>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <locale>
+#include <sstream>
 
 namespace priv::brace {
 
 template<typename T, typename E>
 using Result = ::brace::Result<T, E>;
-using Unit = ::brace::Unit;
+using ErrorCode = ::brace::ErrorCode;
+
+namespace {
+
+// Inputs smaller than this are not worth building a structural index for
+constexpr size_t index_min_size = 256;
+// How much input the structural index covers at a time
+constexpr size_t index_window_size = 16 * 1024;
+
+enum CharClass : uint8_t {
+    Alpha = 1 << 0,
+    Digit = 1 << 1,
+    Punct = 1 << 2,
+    Space = 1 << 3,
+};
+
+// ASCII character classes, independent of the current locale
+constexpr std::array<uint8_t, 256> make_char_classes() {
+    std::array<uint8_t, 256> classes {};
+    for (int c = 0; c < 256; c++) {
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+            classes[c] = Alpha;
+        } else if (c >= '0' && c <= '9') {
+            classes[c] = Digit;
+        } else if ((c >= '!' && c <= '/') || (c >= ':' && c <= '@')
+                   || (c >= '[' && c <= '`') || (c >= '{' && c <= '~')) {
+            classes[c] = Punct;
+        } else if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            classes[c] = Space;
+        }
+    }
+    return classes;
+}
 
-Result<std::vector<Token>, TokenizeError>
-Tokenizer::tokenize(const std::string& code) {
-    m_line = 1;
-    m_column = 1;
-    m_current = 0;
-    m_tokens.clear();
+constexpr std::array<uint8_t, 256> char_classes = make_char_classes();
+
+inline bool is_class(char c, uint8_t mask) {
+    return (char_classes[static_cast<uint8_t>(c)] & mask) != 0;
+}
+
+inline bool is_simple_escape(char c) {
+    switch (c) {
+        case '"':
+        case '\\':
+        case '/':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't': return true;
+        default: return false;
+    }
+}
+
+constexpr uint32_t invalid_code_unit = UINT32_MAX;
+
+// Reads the four hex digits of a \u escape starting at `offset`
+uint32_t read_hex4(std::string_view code, size_t offset) {
+    if (offset + 4 > code.size()) {
+        return invalid_code_unit;
+    }
+    uint32_t unit = 0;
+    for (size_t i = offset; i < offset + 4; i++) {
+        char c = code[i];
+        uint32_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return invalid_code_unit;
+        }
+        unit = (unit << 4) | digit;
+    }
+    return unit;
+}
+
+char* encode_utf8(uint32_t code_point, char* out) {
+    if (code_point < 0x80) {
+        *out++ = static_cast<char>(code_point);
+    } else if (code_point < 0x800) {
+        *out++ = static_cast<char>(0xc0 | (code_point >> 6));
+        *out++ = static_cast<char>(0x80 | (code_point & 0x3f));
+    } else if (code_point < 0x10000) {
+        *out++ = static_cast<char>(0xe0 | (code_point >> 12));
+        *out++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3f));
+        *out++ = static_cast<char>(0x80 | (code_point & 0x3f));
+    } else {
+        *out++ = static_cast<char>(0xf0 | (code_point >> 18));
+        *out++ = static_cast<char>(0x80 | ((code_point >> 12) & 0x3f));
+        *out++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3f));
+        *out++ = static_cast<char>(0x80 | (code_point & 0x3f));
+    }
+    return out;
+}
+
+inline bool is_alpha(char c) {
+    return is_class(c, Alpha);
+}
+
+inline bool is_digit(char c) {
+    return is_class(c, Digit);
+}
+
+inline bool is_alnum(char c) {
+    return is_class(c, Alpha | Digit);
+}
+
+inline bool is_punct(char c) {
+    return is_class(c, Punct);
+}
+
+inline bool is_space(char c) {
+    return is_class(c, Space);
+}
+
+}  // namespace
+
+SourceLocation locate(std::string_view code, size_t offset) {
+    offset = std::min(offset, code.size());
+
+    SourceLocation location {1, 1};
+    size_t line_start = 0;
+    for (size_t i = 0; i < offset; i++) {
+        if (code[i] == '\n') {
+            location.line++;
+            line_start = i + 1;
+        }
+    }
+    location.column = offset - line_start + 1;
+    return location;
+}
 
-    TRY(scan_tokens(code));
+Result<std::vector<Token>, TokenizeError>
+Tokenizer::tokenize(std::string_view code) {
+    reset(code);
+
+    std::vector<Token> tokens;
+    while (true) {
+        TRY_ASSIGN_MOVE(token, next_token(code));
+        bool is_eof = token.type == TokenType::Eof;
+        tokens.push_back(std::move(token));
+        if (is_eof) {
+            break;
+        }
+    }
 
-    add_token(TokenType::Eof);
+    return tokens;
+}
 
-    return m_tokens;
+void Tokenizer::reset(std::string_view code, size_t offset, bool padded) {
+    m_current = offset;
+    m_token_start = offset;
+    m_padded = padded;
+    m_indexer.reset(offset, padded);
+    m_next_structural = 0;
+    m_use_index = code.size() >= index_min_size
+        && code.size() < StructuralIndexer::max_input_size;
 }
 
-void Tokenizer::skip_whitespace(const std::string& code) {
+void Tokenizer::skip_whitespace(std::string_view code) {
     while (!is_at_end(code)) {
         char c = peek(code);
-        if (c == ' ' || c == '\r' || c == '\t' || c == '\n') {
+        if (is_space(c)) {
             advance(code);
         }
         // JSON consumed by this will likely be config
@@ -51,147 +201,385 @@ void Tokenizer::skip_whitespace(const std::string& code) {
     }
 }
 
-Result<Unit, TokenizeError> Tokenizer::scan_tokens(const std::string& code) {
-    while (!is_at_end(code)) {
+void Tokenizer::skip_to_next_token(std::string_view code) {
+    if (!m_use_index) {
         skip_whitespace(code);
-        if (is_at_end(code)) {
-            break;
-        }
+        return;
+    }
 
-        size_t token_start = m_current;
-        char c = peek(code);
+    if (is_at_end(code)) {
+        return;
+    }
 
-        if (std::isalpha(c)) {
-            auto res = keyword(code);
-            if (res.is_err()) {
-                return res.unwrap_err();
-            }
-        } else if (std::isdigit(c)
-                   || (c == '-' && std::isdigit(peek_next(code)))) {
-            auto res = number(code);
-            if (res.is_err()) {
-                return res.unwrap_err();
-            }
-        } else if (c == '\"') {
-            auto res = string(code);
-            if (res.is_err()) {
-                return res.unwrap_err();
-            }
-        } else if (std::ispunct(c)) {
-            auto res = punctuation(code);
-            if (res.is_err()) {
-                return res.unwrap_err();
-            }
-        } else {
-            return TokenizeError(
-                m_line,
-                m_column,
-                "Unexepcted character: '",
-                c,
-                "'"
-            );
+    char c = peek(code);
+    if (c == '/') {
+        // A comment the index has not reached yet
+        m_use_index = false;
+        skip_whitespace(code);
+        return;
+    } else if (!is_space(c)) {
+        // Either a token starts right here, or the previous token stopped
+        // early and whatever follows it gets reported by the lexer
+        return;
+    }
+
+    // Outside of strings the next byte that is not whitespace is always
+    // the next entry of the index
+    while (true) {
+        const uint32_t* structurals = m_indexer.structurals();
+        size_t count = m_indexer.size();
+        while (m_next_structural < count
+               && structurals[m_next_structural] < m_current) {
+            m_next_structural++;
+        }
+        if (m_next_structural < count) {
+            m_current = structurals[m_next_structural++];
+            return;
+        }
+        if (m_indexer.position() >= code.size()) {
+            m_current = code.size();  // Only whitespace is left
+            return;
+        }
+
+        m_next_structural = 0;
+        if (!m_indexer.scan(code, index_window_size)) {
+            m_use_index = false;
+            skip_whitespace(code);
+            return;
         }
     }
-    return Unit {};
 }
 
-Result<Unit, TokenizeError> Tokenizer::keyword(const std::string& code) {
+Result<Token, TokenizeError> Tokenizer::next_token(std::string_view code) {
+    skip_to_next_token(code);
+
+    m_token_start = m_current;
+
+    if (is_at_end(code)) {
+        return make_token(TokenType::Eof, "");
+    }
+
+    char c = peek(code);
+
+    if (is_alpha(c)) {
+        return keyword(code);
+    } else if (is_digit(c) || (c == '-' && is_digit(peek_next(code)))) {
+        return number(code);
+    } else if (c == '\"') {
+        return string(code);
+    } else if (is_punct(c)) {
+        return punctuation(code);
+    }
+
+    return error(ErrorCode::UnexpectedCharacter, code.substr(m_current, 1));
+}
+
+Result<Token, TokenizeError>
+Tokenizer::scan_token(std::string_view code, size_t offset) {
+    m_current = offset;
+    m_use_index = false;
+    m_padded = false;
+    return next_token(code);
+}
+
+Result<Token, TokenizeError> Tokenizer::keyword(std::string_view code) {
     size_t start = m_current;
-    while (!is_at_end(code) && std::isalnum(peek(code))) {
+    while (!is_at_end(code) && is_alnum(peek(code))) {
         advance(code);
     }
 
-    std::string lexeme = code.substr(start, m_current - start);
+    std::string_view lexeme(code.data() + start, m_current - start);
 
-    static const std::unordered_set<std::string> keywords =
-        {"true", "false", "null"};
-
-    if (keywords.find(lexeme) != keywords.end()) {
-        add_token(TokenType::Keyword, lexeme);
-    } else {
-        return TokenizeError(m_line, m_column, "Unregonized keyword: ", lexeme);
+    if (lexeme != "true" && lexeme != "false" && lexeme != "null") {
+        return TokenizeError(ErrorCode::UnknownKeyword, start, lexeme);
     }
 
-    return Unit {};
+    return make_token(TokenType::Keyword, lexeme);
 }
 
-Result<Unit, TokenizeError> Tokenizer::number(const std::string& code) {
+Result<Token, TokenizeError> Tokenizer::number(std::string_view code) {
     size_t start = m_current;
+    bool is_integer = true;
 
-    bool has_decimal = false;
-
-    bool is_negative = false;
     if (peek(code) == '-') {
-        is_negative = true;
         advance(code);  // Consume '-'
     }
 
-    while (!is_at_end(code) && std::isdigit(peek(code))) {
+    // No leading zeros, a zero is only allowed on its own
+    if (peek(code) == '0') {
         advance(code);
+        if (is_digit(peek(code))) {
+            return error(ErrorCode::InvalidNumber);
+        }
+    } else {
+        while (is_digit(peek(code))) {
+            advance(code);
+        }
     }
 
-    if (!is_at_end(code) && peek(code) == '.') {
-        has_decimal = true;
+    if (peek(code) == '.') {
+        is_integer = false;
         advance(code);
 
-        if (!std::isdigit(peek(code))) {
-            return TokenizeError(m_line, m_column, "Invalid number format");
+        if (!is_digit(peek(code))) {
+            return error(ErrorCode::InvalidNumber);
         }
-
-        while (!is_at_end(code) && std::isdigit(peek(code))) {
+        while (is_digit(peek(code))) {
             advance(code);
         }
     }
 
-    std::string lexeme = code.substr(start, m_current - start);
+    if (peek(code) == 'e' || peek(code) == 'E') {
+        is_integer = false;
+        advance(code);
 
-    add_token(TokenType::NumberLiteral, lexeme);
+        if (peek(code) == '+' || peek(code) == '-') {
+            advance(code);
+        }
+        if (!is_digit(peek(code))) {
+            return error(ErrorCode::InvalidNumber);
+        }
+        while (is_digit(peek(code))) {
+            advance(code);
+        }
+    }
 
-    return Unit {};
+    std::string_view lexeme(code.data() + start, m_current - start);
+    Token token = make_token(TokenType::NumberLiteral, lexeme);
+    token.is_integer = is_integer;
+    return token;
 }
 
-Result<Unit, TokenizeError> Tokenizer::string(const std::string& code) {
+Result<Token, TokenizeError> Tokenizer::string(std::string_view code) {
     advance(code);
     size_t start = m_current;
-    std::string value;
+    bool has_escapes = false;
+    bool non_ascii = false;
+
+    // Jump from one quote, backslash or line feed to the next, the bytes in
+    // between are part of the literal as they are
+    while (true) {
+        m_current =
+            find_string_delimiter(code, m_current, non_ascii, m_padded);
+        if (is_at_end(code) || peek(code) == '\n') {
+            return error(ErrorCode::UnterminatedString);
+        }
+        if (advance(code) == '\"') {
+            break;
+        }
 
-    while (!is_at_end(code) && peek(code) != '\"') {
-        if (peek(code) == '\n') {
-            return TokenizeError(
-                m_line,
-                m_column,
-                "Unterminated string literal"
-            );
+        // Escapes are only validated here, decoding is left to whoever
+        // needs the value
+        has_escapes = true;
+        if (is_at_end(code)) {
+            return error(ErrorCode::UnterminatedString);
+        }
+        char escape = advance(code);
+        if (escape == 'u') {
+            if (!unicode_escape(code)) {
+                return error(ErrorCode::InvalidUnicodeEscape);
+            }
+        } else if (!is_simple_escape(escape)) {
+            m_current--;
+            return error(ErrorCode::InvalidEscape, code.substr(m_current - 1, 2));
         }
-        value += advance(code);
     }
 
-    if (is_at_end(code)) {
-        return TokenizeError(m_line, m_column, "Unterminated string literal");
+    std::string_view value(code.data() + start, m_current - start - 1);
+    if (non_ascii && !validate_utf8(value)) {
+        m_current = start;
+        return error(ErrorCode::InvalidUtf8);
     }
+    return make_token(TokenType::StringLiteral, value, has_escapes);
+}
 
-    advance(code);
-    add_token(TokenType::StringLiteral, value);
-    return Unit {};
+bool Tokenizer::unicode_escape(std::string_view code) {
+    uint32_t unit = read_hex4(code, m_current);
+    if (unit == invalid_code_unit) {
+        return false;
+    }
+    m_current += 4;
+
+    if (unit >= 0xdc00 && unit <= 0xdfff) {
+        return false;  // Low surrogate without a high one
+    } else if (unit >= 0xd800 && unit <= 0xdbff) {
+        if (peek(code) != '\\' || peek_next(code) != 'u') {
+            return false;
+        }
+        uint32_t low = read_hex4(code, m_current + 2);
+        if (low < 0xdc00 || low > 0xdfff) {
+            return false;
+        }
+        m_current += 6;
+    }
+    return true;
+}
+
+// Accumulates the digits of an integer literal, false if it overflows
+static bool parse_integer(std::string_view digits, uint64_t& out) {
+    uint64_t value = 0;
+    for (char c : digits) {
+        uint64_t digit = static_cast<uint64_t>(c - '0');
+        if (value > (UINT64_MAX - digit) / 10) {
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+    out = value;
+    return true;
+}
+
+// Whether a literal out of the range of double is out of it because it is
+// too close to zero rather than too large. Its syntax was checked by the
+// tokenizer already.
+bool underflows(std::string_view lexeme) {
+    size_t i = lexeme.front() == '-' ? 1 : 0;
+    // Power of ten of the first significant digit, before the exponent
+    int64_t power = -1;
+    bool significant = false;
+    for (; i < lexeme.size() && is_digit(lexeme[i]); i++) {
+        if (significant || lexeme[i] != '0') {
+            significant = true;
+            power++;
+        }
+    }
+    if (i < lexeme.size() && lexeme[i] == '.') {
+        for (i++; i < lexeme.size() && is_digit(lexeme[i]); i++) {
+            if (significant) {
+                continue;
+            }
+            significant = lexeme[i] != '0';
+            power--;
+        }
+    }
+
+    int64_t exponent = 0;
+    bool negative = false;
+    if (i < lexeme.size() && (lexeme[i] == 'e' || lexeme[i] == 'E')) {
+        i++;
+        negative = lexeme[i] == '-';
+        if (lexeme[i] == '-' || lexeme[i] == '+') {
+            i++;
+        }
+        // Saturates, far beyond any exponent double can hold
+        for (; i < lexeme.size() && exponent < 1000000000; i++) {
+            exponent = exponent * 10 + (lexeme[i] - '0');
+        }
+    }
+    return power + (negative ? -exponent : exponent) < 0;
 }
 
-Result<Unit, TokenizeError> Tokenizer::punctuation(const std::string& code) {
+bool parse_number(const Token& token, Number& out) {
+    std::string_view lexeme = token.lexeme;
+    bool negative = lexeme.front() == '-';
+
+    uint64_t magnitude;
+    if (token.is_integer
+        && parse_integer(lexeme.substr(negative ? 1 : 0), magnitude)) {
+        if (!negative) {
+            out.kind = NumberKind::Uint64;
+            out.uint64 = magnitude;
+            return true;
+        } else if (magnitude <= uint64_t(INT64_MAX) + 1) {
+            // Negated in unsigned arithmetic so INT64_MIN does not overflow
+            out.kind = NumberKind::Int64;
+            out.int64 = static_cast<int64_t>(0 - magnitude);
+            return true;
+        }
+    }
+
+    out.kind = NumberKind::Double;
+#if defined(__cpp_lib_to_chars)
+    auto result = std::from_chars(
+        lexeme.data(),
+        lexeme.data() + lexeme.size(),
+        out.number
+    );
+    bool parsed = result.ec == std::errc();
+#else
+    std::istringstream stream {std::string(lexeme)};
+    stream.imbue(std::locale::classic());
+    stream >> out.number;
+    bool parsed = !stream.fail();
+#endif
+    // Only literals too large for a double are rejected, ones too small
+    // round to zero
+    if (!parsed && underflows(lexeme)) {
+        out.number = negative ? -0.0 : 0.0;
+        return true;
+    }
+    return parsed;
+}
+
+size_t unescape(std::string_view lexeme, char* out) {
+    char* begin = out;
+    size_t i = 0;
+
+    while (true) {
+        size_t backslash = lexeme.find('\\', i);
+        if (backslash == std::string_view::npos) {
+            backslash = lexeme.size();
+        }
+        std::memcpy(out, lexeme.data() + i, backslash - i);
+        out += backslash - i;
+        if (backslash == lexeme.size()) {
+            break;
+        }
+
+        char escape = lexeme[backslash + 1];
+        i = backslash + 2;
+        switch (escape) {
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u': {
+                uint32_t code_point = read_hex4(lexeme, i);
+                i += 4;
+                if (code_point >= 0xd800 && code_point <= 0xdbff) {
+                    uint32_t low = read_hex4(lexeme, i + 2);
+                    i += 6;
+                    code_point =
+                        0x10000 + ((code_point - 0xd800) << 10) + (low - 0xdc00);
+                }
+                out = encode_utf8(code_point, out);
+                break;
+            }
+            default: *out++ = escape; break;  // '"', '\\' and '/'
+        }
+    }
+
+    return static_cast<size_t>(out - begin);
+}
+
+Result<Token, TokenizeError> Tokenizer::punctuation(std::string_view code) {
     char c = peek(code);
-    std::string lexeme(1, c);
+    std::string_view lexeme(code.data() + m_current, 1);
     advance(code);
 
-    if (c == ';' || c == ':' || c == ',' || c == '(' || c == ')' || c == '{'
-        || c == '}' || c == '[' || c == ']') {
-        add_token(TokenType::Punctuation, lexeme);
-        return Unit {};
+    switch (c) {
+        case '{':
+            return make_token(TokenType::LeftBrace, lexeme);
+        case '}':
+            return make_token(TokenType::RightBrace, lexeme);
+        case '[':
+            return make_token(TokenType::LeftBracket, lexeme);
+        case ']':
+            return make_token(TokenType::RightBracket, lexeme);
+        case ':':
+            return make_token(TokenType::Colon, lexeme);
+        case ',':
+            return make_token(TokenType::Comma, lexeme);
+        case ';':
+        case '(':
+        case ')':
+            return make_token(TokenType::Punctuation, lexeme);
+        default:
+            break;
     }
 
-    return TokenizeError(
-        m_line,
-        m_column,
-        "Unrecognized punctuation: ",
-        lexeme
-    );
+    return TokenizeError(ErrorCode::UnexpectedCharacter, m_current - 1, lexeme);
 }
 
 }  // namespace priv::brace
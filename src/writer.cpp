@@ -0,0 +1,190 @@
+#include <brace/writer.h>
+
+#include <algorithm>
+#include <charconv>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+
+namespace brace {
+
+namespace {
+
+// Output is handed to the sink in chunks of about this size
+constexpr size_t sink_chunk_size = 64 * 1024;
+
+// Enough for any int64_t, uint64_t or shortest round-trip double
+constexpr size_t max_number_size = 32;
+
+constexpr char hex_digits[] = "0123456789abcdef";
+
+}  // namespace
+
+void Writer::write(const JsonValue& value) {
+    m_depth = 0;
+    write_value(value);
+    if (m_sink && !m_buffer.empty()) {
+        m_sink(m_buffer);
+        m_buffer.clear();
+    }
+}
+
+void Writer::write_value(const JsonValue& value) {
+    char number[max_number_size];
+
+    switch (value.type()) {
+        case JsonType::Null: m_buffer.append("null"); break;
+        case JsonType::Bool:
+            m_buffer.append(static_cast<bool>(value) ? "true" : "false");
+            break;
+        case JsonType::Int64: {
+            auto result =
+                std::to_chars(number, number + sizeof(number), value.to_int64());
+            m_buffer.append(number, result.ptr);
+            break;
+        }
+        case JsonType::Uint64: {
+            auto result = std::to_chars(
+                number,
+                number + sizeof(number),
+                value.to_uint64()
+            );
+            m_buffer.append(number, result.ptr);
+            break;
+        }
+        case JsonType::Double: write_double(value.to_double()); break;
+        case JsonType::String: write_string(value.to_string_view()); break;
+        case JsonType::Object: write_object(value.to_object()); break;
+        case JsonType::Array: write_array(value.to_array()); break;
+    }
+}
+
+void Writer::write_object(const JsonObject& object) {
+    if (object.empty()) {
+        m_buffer.append("{}");
+        return;
+    }
+
+    m_buffer.push_back('{');
+    m_depth++;
+    bool first = true;
+    for (const auto& [key, value] : object) {
+        if (!first) {
+            m_buffer.push_back(',');
+        }
+        first = false;
+        write_newline();
+        write_string(key);
+        m_buffer.append(m_indent ? ": " : ":");
+        write_value(value);
+        flush_if_full();
+    }
+    m_depth--;
+    write_newline();
+    m_buffer.push_back('}');
+}
+
+void Writer::write_array(const JsonArray& array) {
+    if (array.empty()) {
+        m_buffer.append("[]");
+        return;
+    }
+
+    m_buffer.push_back('[');
+    m_depth++;
+    bool first = true;
+    for (const JsonValue& value : array) {
+        if (!first) {
+            m_buffer.push_back(',');
+        }
+        first = false;
+        write_newline();
+        write_value(value);
+        flush_if_full();
+    }
+    m_depth--;
+    write_newline();
+    m_buffer.push_back(']');
+}
+
+void Writer::write_string(std::string_view text) {
+    m_buffer.push_back('"');
+
+    // Copy the runs that need no escaping in one go
+    size_t start = 0;
+    while (true) {
+        size_t end = ::priv::brace::find_escape_char(text, start);
+        m_buffer.append(text.data() + start, end - start);
+        if (end == text.size()) {
+            break;
+        }
+
+        char c = text[end];
+        switch (c) {
+            case '"': m_buffer.append("\\\""); break;
+            case '\\': m_buffer.append("\\\\"); break;
+            case '\b': m_buffer.append("\\b"); break;
+            case '\f': m_buffer.append("\\f"); break;
+            case '\n': m_buffer.append("\\n"); break;
+            case '\r': m_buffer.append("\\r"); break;
+            case '\t': m_buffer.append("\\t"); break;
+            default: {
+                char escape[] = {'\\', 'u', '0', '0', 0, 0};
+                escape[4] = hex_digits[(c >> 4) & 0xf];
+                escape[5] = hex_digits[c & 0xf];
+                m_buffer.append(escape, sizeof(escape));
+                break;
+            }
+        }
+        start = end + 1;
+    }
+
+    m_buffer.push_back('"');
+}
+
+void Writer::write_double(double number) {
+    if (!std::isfinite(number)) {
+        m_buffer.append("null");
+        return;
+    }
+
+    char digits[max_number_size];
+#if defined(__cpp_lib_to_chars)
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    std::string_view text(digits, result.ptr - digits);
+#else
+    int size = std::snprintf(digits, sizeof(digits), "%.17g", number);
+    // snprintf follows the locale's decimal point
+    char decimal_point = *std::localeconv()->decimal_point;
+    std::replace(digits, digits + size, decimal_point, '.');
+    std::string_view text(digits, size);
+#endif
+
+    m_buffer.append(text);
+    // Keep doubles doubles when they are parsed back
+    if (text.find_first_of(".e") == std::string_view::npos) {
+        m_buffer.append(".0");
+    }
+}
+
+void Writer::write_newline() {
+    if (m_indent) {
+        m_buffer.push_back('\n');
+        m_buffer.append(m_depth * m_indent, ' ');
+    }
+}
+
+void Writer::flush_if_full() {
+    if (m_sink && m_buffer.size() >= sink_chunk_size) {
+        m_sink(m_buffer);
+        m_buffer.clear();
+    }
+}
+
+std::string JsonValue::to_string(size_t indent) const {
+    Writer writer(indent);
+    writer.write(*this);
+    return writer.take();
+}
+
+}  // namespace brace
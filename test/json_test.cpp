@@ -1,10 +1,70 @@
 
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <brace/brace.h>
+#include <brace/fields.h>
+#include <brace/lazy.h>
+#include <brace/path.h>
+#include <brace/sax.h>
+#include <brace/snapshot.h>
+#include <brace/stream.h>
+#include <brace/writer.h>
 #include <doctest/doctest.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <thread>
+
 using namespace brace;
 
+// A path of its own in the temporary directory, removed along with it
+class TempFile {
+  public:
+    TempFile() {
+        std::random_device random;
+        std::string name = "brace_test_" + std::to_string(random()) + "_"
+            + std::to_string(random());
+        m_path = (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    ~TempFile() {
+        std::error_code ignored;
+        std::filesystem::remove(m_path, ignored);
+    }
+
+    const std::string& path() const {
+        return m_path;
+    }
+
+  private:
+    std::string m_path;
+};
+
+class CountingResource: public std::pmr::memory_resource {
+  public:
+    size_t allocations = 0;
+
+  private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        allocations++;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other
+    ) const noexcept override {
+        return this == &other;
+    }
+};
+
 JsonValue parse_json(const std::string& json_str) {
     Parser parser;
     return parser.parse(json_str).unwrap_ok();
@@ -99,3 +159,1622 @@ TEST_CASE("More complex parsing") {
         CHECK(value["meta"]["timestamp"] == 1700000000);
     }
 }
+
+TEST_CASE("Malformed input") {
+    Parser parser;
+
+    SUBCASE("Errors inside a value are reported") {
+        CHECK(parser.parse(R"({"a": 1, "b": @})").is_err());
+        CHECK(parser.parse(R"([1, 2)").is_err());
+        CHECK(parser.parse("{").is_err());
+    }
+
+    SUBCASE("Errors after the value are reported") {
+        CHECK(parser.parse("[1] @").is_err());
+    }
+
+    SUBCASE("Parser is reusable after an error") {
+        CHECK(parser.parse("[").is_err());
+        auto value = parser.parse(R"({"ok": true})").unwrap_ok();
+        CHECK(value["ok"].is_bool());
+    }
+
+    SUBCASE("Errors carry a code and where they happened") {
+        auto err = parser.parse("{\n  \"a\": 1,\n  \"b\" 2\n}").unwrap_err();
+        CHECK(err.code() == ErrorCode::ExpectedColon);
+        CHECK(err.offset() == 18);
+        CHECK(err.line() == 3);
+        CHECK(err.column() == 7);
+        CHECK(err.message() == "Expected ':' after key in object at line 3, column 7");
+
+        err = parser.parse("[1, @]").unwrap_err();
+        CHECK(err.code() == ErrorCode::UnexpectedCharacter);
+        CHECK(err.detail() == "@");
+        CHECK(err.line() == 1);
+        CHECK(err.column() == 5);
+
+        CHECK(parser.parse(R"({"a": )").unwrap_err().code() == ErrorCode::UnexpectedEnd);
+        CHECK(parser.parse("[1e999]").unwrap_err().detail() == "1e999");
+    }
+
+    SUBCASE("Chunked errors are located within the whole input") {
+        StreamParser stream;
+        CHECK(stream.feed("[1,\n").is_ok());
+        auto err = stream.feed(" 2 } ").unwrap_err();
+        CHECK(err.code() == ErrorCode::ExpectedCommaOrBracket);
+        CHECK(err.offset() == 7);
+        CHECK(err.line() == 2);
+        CHECK(err.column() == 4);
+    }
+}
+
+TEST_CASE("Results") {
+    auto make = [](bool ok) -> Result<std::unique_ptr<int>, ParseError> {
+        if (!ok) {
+            return ParseError(ErrorCode::Cancelled, 0, 1, 1);
+        }
+        return std::make_unique<int>(2);
+    };
+    auto twice = [&](bool ok) -> Result<int, ParseError> {
+        TRY_ASSIGN(value, make(ok));
+        return *value * 2;
+    };
+
+    SUBCASE("Move-only values propagate") {
+        CHECK(twice(true).unwrap() == 4);
+        CHECK(twice(false).unwrap_err().code() == ErrorCode::Cancelled);
+        auto doubled = make(true).map([](std::unique_ptr<int>&& p) { return *p * 2; });
+        CHECK(doubled.unwrap() == 4);
+        auto owned = make(true).and_then([](std::unique_ptr<int>&& p) {
+            return Result<std::unique_ptr<int>, ParseError>(std::move(p));
+        });
+        CHECK(*std::move(owned).unwrap() == 2);
+    }
+}
+
+TEST_CASE("Punctuation inside strings") {
+    auto value = parse_json(R"({"}": "]", "list": ["," , ":"]})");
+
+    CHECK(value["}"] == "]");
+    auto& list = value["list"].to_array();
+    CHECK(list.size() == 2);
+    CHECK(list[0] == ",");
+    CHECK(list[1] == ":");
+}
+
+TEST_CASE("Documents and memory resources") {
+    std::string json_str = R"({"name": "brace", "tags": ["json", "arena"]})";
+    Parser parser;
+
+    SUBCASE("Document owns its values") {
+        auto document = parser.parse_document(json_str).unwrap_ok();
+        CHECK(document.root().is_object());
+        CHECK(document.root()["name"] == "brace");
+        CHECK(document.root()["tags"].to_array().size() == 2);
+    }
+
+    SUBCASE("Copies outlive the document") {
+        JsonValue tags;
+        {
+            auto document = parser.parse_document(json_str).unwrap_ok();
+            tags = document.root()["tags"];
+        }
+        CHECK(tags.to_array()[1] == "arena");
+    }
+
+    SUBCASE("Values allocate from the parser's resource") {
+        CountingResource resource;
+        parser.set_memory_resource(&resource);
+        {
+            auto value = parser.parse(json_str).unwrap_ok();
+            CHECK(value["name"] == "brace");
+        }
+        size_t value_allocations = resource.allocations;
+        CHECK(value_allocations > 0);
+
+        resource.allocations = 0;
+        {
+            auto document = parser.parse_document(json_str).unwrap_ok();
+            CHECK(document.root()["tags"].to_array()[0] == "json");
+        }
+        CHECK(resource.allocations > 0);
+        CHECK(resource.allocations < value_allocations);
+    }
+
+    SUBCASE("Documents are reused without allocating") {
+        std::string large_str = "[";
+        for (int i = 0; i < 1000; i++) {
+            large_str += json_str + ",";
+        }
+        large_str += "null]";
+
+        CountingResource resource;
+        Document document(&resource);
+        for (int i = 0; i < 3; i++) {
+            REQUIRE(parser.parse_document(large_str, document).is_ok());
+            CHECK(document.root().to_array().size() == 1001);
+        }
+        size_t allocations = resource.allocations;
+        REQUIRE(parser.parse_document(json_str, document).is_ok());
+        CHECK(document.root()["name"] == "brace");
+        REQUIRE(parser.parse_document(large_str, document).is_ok());
+        CHECK(resource.allocations == allocations);
+
+        CHECK(parser.parse_document("[1, 2", document).is_err());
+        CHECK(document.root().is_null());
+    }
+}
+
+TEST_CASE("Large indented documents") {
+    std::string json_str = "[\n";
+    for (int i = 0; i < 100; i++) {
+        json_str += "    {\n        \"id\": " + std::to_string(i)
+            + ",\n        \"quote\": \"say \\\"hi\\\"\",\n"
+            + "        \"tags\": [ \"a\" , \"b\" ]\n    }";
+        json_str += i < 99 ? ",\n" : "\n";
+    }
+    json_str += "]\n";
+
+    SUBCASE("Values are intact") {
+        auto value = parse_json(json_str);
+        auto& records = value.to_array();
+        CHECK(records.size() == 100);
+        CHECK(records[42]["id"] == 42);
+        CHECK(records[99]["id"] == 99);
+        CHECK(records[99]["tags"].to_array().size() == 2);
+    }
+
+    SUBCASE("Comments are allowed anywhere") {
+        json_str.insert(json_str.size() / 2, "\n// halfway there\n");
+        json_str.insert(json_str.find('[', 1), "/* tags */ ");
+        auto value = parse_json(json_str);
+        CHECK(value.to_array().size() == 100);
+    }
+
+    SUBCASE("Malformed records are reported") {
+        size_t pos = json_str.rfind("\"tags\"");
+        json_str.insert(pos, "@");
+        Parser parser;
+        CHECK(parser.parse(json_str).is_err());
+    }
+}
+
+TEST_CASE("Long strings") {
+    std::string blob;
+    for (int i = 0; i < 1000; i++) {
+        blob += static_cast<char>('A' + i % 26);
+    }
+
+    SUBCASE("Contents are kept whole") {
+        auto value = parse_json(R"({"blob": ")" + blob + R"(", "after": 1})");
+        CHECK(value["blob"] == blob);
+        CHECK(value["after"] == 1);
+    }
+
+    SUBCASE("Escaped backslashes before the closing quote") {
+        auto value = parse_json(R"({"blob": ")" + blob + R"(\\", "after": 1})");
+        CHECK(value["blob"] == blob + "\\");
+        CHECK(value["after"] == 1);
+    }
+
+    SUBCASE("Unterminated strings are reported") {
+        Parser parser;
+        CHECK(parser.parse(R"({"blob": ")" + blob).is_err());
+        CHECK(parser.parse(R"({"blob": ")" + blob + "\n\"}").is_err());
+    }
+}
+
+TEST_CASE("Escape sequences") {
+    SUBCASE("Simple escapes are decoded") {
+        auto value = parse_json(R"(["\"\\\/", "a\b\f\n\r\tb"])");
+        auto& list = value.to_array();
+        CHECK(list[0] == "\"\\/");
+        CHECK(list[1] == "a\b\f\n\r\tb");
+    }
+
+    SUBCASE("Unicode escapes are encoded as UTF-8") {
+        auto value = parse_json(R"(["\u0041\u00e9\u20AC", "\ud83d\ude00"])");
+        auto& list = value.to_array();
+        CHECK(list[0] == "A\xc3\xa9\xe2\x82\xac");
+        CHECK(list[1] == "\xf0\x9f\x98\x80");
+    }
+
+    SUBCASE("Keys are decoded") {
+        auto value = parse_json(R"({"line\nbreak": 1, "caf\u00e9": 2})");
+        CHECK(value["line\nbreak"] == 1);
+        CHECK(value["caf\xc3\xa9"] == 2);
+    }
+
+    SUBCASE("Invalid escapes are reported") {
+        Parser parser;
+        CHECK(parser.parse(R"(["\x"])").is_err());
+        CHECK(parser.parse(R"(["\u12"])").is_err());
+        CHECK(parser.parse(R"(["\u12g4"])").is_err());
+        CHECK(parser.parse(R"(["\ud83d"])").is_err());
+        CHECK(parser.parse(R"(["\ud83d\u0041"])").is_err());
+        CHECK(parser.parse(R"(["\ude00"])").is_err());
+    }
+
+    SUBCASE("Raw UTF-8 is validated") {
+        Parser parser;
+        std::string text = "\xc3\xa9t\xc3\xa9 \xf0\x9f\x98\x80";
+        auto value = parse_json("[\"" + text + "\"]");
+        CHECK(value.to_array()[0] == text);
+        CHECK(parser.parse("[\"\xff\"]").is_err());
+        CHECK(parser.parse("[\"\xc3\"]").is_err());
+        CHECK(parser.parse("[\"\xc0\xaf\"]").is_err());
+        CHECK(parser.parse("[\"\xed\xa0\x80\"]").is_err());
+    }
+}
+
+TEST_CASE("Numbers") {
+    SUBCASE("Exponents and fractions are parsed") {
+        auto value =
+            parse_json("[1e9, 2.5E-3, -1.25e+2, 0.5, -0, 0, 1e-400, -1e-400]");
+        auto& list = value.to_array();
+        CHECK(list[0] == 1e9);
+        CHECK(list[1] == 2.5e-3);
+        CHECK(list[2] == -125.0);
+        CHECK(list[3] == 0.5);
+        CHECK(list[4] == 0.0);
+        CHECK(list[5] == 0);
+        // Too small for a double, rounded to zero
+        CHECK(list[6] == 0.0);
+        CHECK_FALSE(std::signbit(list[6].to_double()));
+        CHECK(list[7] == 0.0);
+        CHECK(std::signbit(list[7].to_double()));
+    }
+
+    SUBCASE("Long literals are parsed") {
+        auto value = parse_json(
+            "[12345678901234567890123, 3.141592653589793238462643383279]"
+        );
+        auto& list = value.to_array();
+        CHECK(list[0] == 12345678901234567890123.0);
+        CHECK(list[1] == 3.141592653589793);
+    }
+
+    SUBCASE("Malformed numbers are reported") {
+        Parser parser;
+        CHECK(parser.parse("[01]").is_err());
+        CHECK(parser.parse("[1.]").is_err());
+        CHECK(parser.parse("[1e]").is_err());
+        CHECK(parser.parse("[1e+]").is_err());
+        CHECK(parser.parse("[-]").is_err());
+        CHECK(parser.parse("[1e400]").is_err());
+    }
+}
+
+TEST_CASE("Integers") {
+    SUBCASE("Integers are stored exactly") {
+        auto value = parse_json(
+            "[9007199254740993, -9223372036854775808, 18446744073709551615]"
+        );
+        auto& list = value.to_array();
+        CHECK(list[0].is_integer());
+        CHECK(list[0].to_int64() == 9007199254740993);
+        CHECK(list[0] == int64_t(9007199254740993));
+        CHECK_FALSE(list[0] == int64_t(9007199254740992));
+        CHECK(list[1].to_int64() == INT64_MIN);
+        CHECK(list[2].to_uint64() == UINT64_MAX);
+        CHECK(list[2] == UINT64_MAX);
+        CHECK_FALSE(list[2] == -1);
+    }
+
+    SUBCASE("Integers and doubles compare by value") {
+        auto value = parse_json("[3, 3.0, 1e2]");
+        auto& list = value.to_array();
+        CHECK(list[0].is_integer());
+        CHECK_FALSE(list[1].is_integer());
+        CHECK(list[0] == 3.0);
+        CHECK(list[1] == 3);
+        CHECK(list[2] == 100);
+        CHECK(static_cast<size_t>(list[2]) == 100);
+        CHECK(list[0].to_double() == 3.0);
+    }
+
+    SUBCASE("Integers too large for 64 bits become doubles") {
+        auto value = parse_json("[18446744073709551616, -9223372036854775809]");
+        auto& list = value.to_array();
+        CHECK_FALSE(list[0].is_integer());
+        CHECK(list[0] == 18446744073709551616.0);
+        CHECK(list[1] == -9223372036854775809.0);
+    }
+}
+
+TEST_CASE("Compact values") {
+    CHECK(sizeof(JsonValue) == 16);
+
+    SUBCASE("Short and long strings keep their contents") {
+        std::string long_str(100, 'x');
+        auto value = parse_json(R"(["", "fourteen bytes", "fifteen bytes!!", ")"
+                                + long_str + R"("])");
+        auto& list = value.to_array();
+        CHECK(list[0] == "");
+        CHECK(list[1] == "fourteen bytes");
+        CHECK(list[2] == "fifteen bytes!!");
+        CHECK(list[3] == long_str);
+        CHECK(list[3].type() == JsonType::String);
+    }
+
+    SUBCASE("Copies are deep and moves leave null behind") {
+        JsonValue original = parse_json(R"({"list": [1, "a long string value"]})");
+        JsonValue copy = original;
+        JsonValue moved = std::move(original);
+        CHECK(original.is_null());
+        CHECK(copy["list"].to_array()[1] == "a long string value");
+        CHECK(moved["list"].to_array()[1] == "a long string value");
+        CHECK(&copy["list"].to_array() != &moved["list"].to_array());
+    }
+
+    SUBCASE("Values allocate only what does not fit inline") {
+        CountingResource resource;
+        Parser parser;
+        parser.set_memory_resource(&resource);
+        auto nulls = parser.parse("[null, null, null, null]").unwrap_ok();
+        size_t array_allocations = resource.allocations;
+
+        resource.allocations = 0;
+        auto value = parser.parse("[1, 2.5, true, \"short\"]").unwrap_ok();
+        CHECK(value.to_array().size() == 4);
+        CHECK(resource.allocations == array_allocations);
+    }
+}
+
+TEST_CASE("Objects") {
+    SUBCASE("Members keep their insertion order") {
+        auto value = parse_json(R"({"zeta": 1, "alpha": 2, "mid": 3})");
+        std::vector<std::string> keys;
+        for (auto& [key, member] : value.to_object()) {
+            keys.emplace_back(key);
+        }
+        CHECK(keys == std::vector<std::string> {"zeta", "alpha", "mid"});
+    }
+
+    SUBCASE("Duplicate keys keep the last value in the first position") {
+        auto value = parse_json(R"({"a": 1, "b": 2, "a": 3})");
+        auto& object = value.to_object();
+        CHECK(object.size() == 2);
+        CHECK(object.begin()->first == "a");
+        CHECK(value["a"] == 3);
+    }
+
+    SUBCASE("Large objects are looked up through the index") {
+        std::string json_str = "{";
+        for (int i = 0; i < 100; i++) {
+            json_str += (i ? ", \"key" : "\"key") + std::to_string(i)
+                + "\": " + std::to_string(i);
+        }
+        json_str += ", \"key7\": -7}";
+        auto value = parse_json(json_str);
+        CHECK(value.to_object().size() == 100);
+        CHECK(value["key0"] == 0);
+        CHECK(value["key7"] == -7);
+        CHECK(value["key99"] == 99);
+        CHECK(value.contains("key42"));
+        CHECK_FALSE(value.contains("key100"));
+
+        JsonObject copy = value.to_object();
+        CHECK(copy.erase("key0") == 1);
+        CHECK(copy.erase("key0") == 0);
+        CHECK(copy.at("key99") == 99);
+        CHECK_FALSE(copy.contains("key0"));
+    }
+
+    SUBCASE("Objects can be built by hand") {
+        JsonObject object;
+        object["name"] = JsonValue(std::string("brace"));
+        object.insert_or_assign("version", JsonValue(1));
+        object["version"] = JsonValue(2);
+        JsonValue value(std::move(object));
+        CHECK(value["name"] == "brace");
+        CHECK(value["version"] == 2);
+        CHECK(value.to_object().size() == 2);
+    }
+
+    SUBCASE("Documents can intern keys") {
+        std::string long_key = "a key too long to be stored inline";
+        std::string json_str = R"([{"id": 1, ")" + long_key + R"(": 1},
+                                   {"id": 2, ")" + long_key + R"(": 2}])";
+        Parser parser;
+        parser.set_intern_keys(true);
+        auto document = parser.parse_document(json_str).unwrap_ok();
+        const JsonKey& first = document.root()[size_t(0)].to_object().begin()[1].first;
+        const JsonKey& second = document.root()[size_t(1)].to_object().begin()[1].first;
+        CHECK(first == long_key);
+        CHECK(first.is_interned());
+        CHECK(first.data() == second.data());
+        CHECK(document.root()[size_t(1)][long_key] == 2);
+        CHECK_FALSE(document.root()[size_t(0)].to_object().begin()->first.is_interned());
+
+        // Copies own their keys
+        JsonValue copy = document.root();
+        CHECK_FALSE(copy[size_t(0)].to_object().begin()[1].first.is_interned());
+        CHECK(copy[size_t(0)][long_key] == 1);
+
+        // Interned keys are indexed without hashing them again
+        std::string large = "{";
+        for (int i = 0; i < 40; i++) {
+            large += (i ? ", \"" : "\"") + long_key + std::to_string(i) + "\": " + std::to_string(i);
+        }
+        large += "}";
+        Document reused;
+        for (int round = 0; round < 2; round++) {
+            REQUIRE(parser.parse_document(large, reused).is_ok());
+            CHECK(reused.root()[long_key + "39"] == 39);
+            CHECK(reused.root().to_object().begin()->first.is_interned());
+        }
+
+        parser.set_intern_keys(false);
+        auto plain = parser.parse_document(json_str).unwrap_ok();
+        CHECK_FALSE(plain.root()[size_t(0)].to_object().begin()[1].first.is_interned());
+    }
+
+    SUBCASE("Documents can intern strings") {
+        std::string json_str = R"([{"status": "waiting for review", "id": 1},
+                                   {"status": "waiting for review", "id": 2},
+                                   {"status": "short", "id": 3}])";
+        Parser parser;
+        parser.set_intern_strings(true);
+        Document document;
+        for (int round = 0; round < 2; round++) {
+            REQUIRE(parser.parse_document(json_str, document).is_ok());
+            const JsonValue& root = document.root();
+            CHECK(root[size_t(0)]["status"] == "waiting for review");
+            CHECK(root[size_t(0)]["status"].to_string_view().data()
+                  == root[size_t(1)]["status"].to_string_view().data());
+            CHECK(root[size_t(2)]["status"] == "short");
+        }
+
+        // Copies own their strings
+        JsonValue copy = document.root();
+        document.reset();
+        CHECK(copy[size_t(1)]["status"] == "waiting for review");
+        CHECK(copy[size_t(0)]["status"].to_string_view().data()
+              != copy[size_t(1)]["status"].to_string_view().data());
+
+        parser.set_intern_strings(false);
+        auto plain = parser.parse_document(json_str).unwrap_ok();
+        CHECK(plain.root()[size_t(0)]["status"].to_string_view().data()
+              != plain.root()[size_t(1)]["status"].to_string_view().data());
+    }
+}
+
+struct Node {
+    std::vector<Node> children;
+    JsonValue data;
+};
+BRACE_FIELDS(Node, children, data)
+
+TEST_CASE("Deep documents") {
+    auto nested = [](int depth) {
+        std::string json_str;
+        for (int i = 0; i < depth; i++) {
+            json_str += R"({"name": "a string too long to inline", "child": )";
+        }
+        json_str += "null";
+        for (int i = 0; i < depth; i++) {
+            json_str += "}";
+        }
+        return json_str;
+    };
+    auto allocations = [](const std::string& json_str) {
+        CountingResource resource;
+        Parser parser;
+        parser.set_memory_resource(&resource);
+        auto value = parser.parse(json_str).unwrap_ok();
+        CHECK(value.is_object());
+        return resource.allocations;
+    };
+
+    SUBCASE("Subtrees are moved, not copied, into their parents") {
+        size_t shallow = allocations(nested(50));
+        size_t deep = allocations(nested(100));
+        CHECK(deep == 2 * shallow);
+    }
+
+    SUBCASE("Lookups do not copy") {
+        auto value = parse_json(nested(100));
+        const JsonValue* node = &value;
+        int depth = 0;
+        while (node->contains("child")) {
+            node = &(*node)["child"];
+            depth++;
+        }
+        CHECK(depth == 100);
+        CHECK(node->is_null());
+    }
+
+    SUBCASE("Nesting is limited") {
+        auto arrays = [](size_t depth) {
+            return std::string(depth, '[') + std::string(depth, ']');
+        };
+        Parser parser;
+        CHECK(parser.parse(arrays(default_max_depth)).is_ok());
+        auto err = parser.parse(arrays(default_max_depth + 1)).unwrap_err();
+        CHECK(err.code() == ErrorCode::DepthExceeded);
+        CHECK(err.offset() == default_max_depth);
+        std::string too_deep = arrays(default_max_depth + 1);
+        CHECK(parser.parse_lazy(too_deep).is_err());
+
+        parser.set_max_depth(2);
+        CHECK(parser.parse(R"({"a": [], "b": {"c": 1}})").is_ok());
+        CHECK(parser.parse(R"({"a": [[]]})").is_err());
+        CHECK(parser.parse_lazy(R"({"a": [[]]})").is_err());
+        CHECK(parser.parse("[[1], [2]]").is_ok());
+
+        StreamParser stream;
+        stream.set_max_depth(2);
+        auto fed = stream.feed("[[1], [[2]]]");
+        CHECK(fed.unwrap_err().code() == ErrorCode::DepthExceeded);
+    }
+
+    SUBCASE("Nesting is limited when parsing into structs") {
+        // Each node is an object holding an array
+        auto nodes = [](size_t depth) {
+            std::string json_str;
+            for (size_t i = 0; i < depth; i++) {
+                json_str += R"({"children": [)";
+            }
+            for (size_t i = 0; i < depth; i++) {
+                json_str += "]}";
+            }
+            return json_str;
+        };
+        Parser parser;
+        Node node;
+        CHECK(parser.parse_into(nodes(default_max_depth / 2), node).is_ok());
+        std::string too_deep = nodes(default_max_depth / 2 + 1);
+        CHECK(parser.parse(too_deep).is_err());
+        auto err = parser.parse_into(too_deep, node).unwrap_err();
+        CHECK(err.code() == ErrorCode::DepthExceeded);
+        CHECK(err.offset() == too_deep.find_last_of('{'));
+        CHECK(parser.parse_into(nodes(100000), node).is_err());
+
+        // JsonValue members and skipped values count the objects they are in
+        parser.set_max_depth(2);
+        CHECK(parser.parse_into(R"({"data": [1]})", node).is_ok());
+        CHECK(parser.parse_into(R"({"data": [[1]]})", node).is_err());
+        CHECK(parser.parse_into(R"({"other": {}})", node).is_ok());
+        CHECK(parser.parse_into(R"({"other": {"a": []}})", node).is_err());
+    }
+
+    SUBCASE("Deep input does not recurse") {
+        struct Counter: SaxHandler<Counter> {
+            size_t arrays = 0;
+            bool on_start_array() { arrays++; return true; }
+        };
+        Parser parser;
+        parser.set_max_depth(SIZE_MAX);
+        Counter counter;
+        std::string deep = std::string(200000, '[') + std::string(200000, ']');
+        CHECK(parser.parse_sax(deep, counter).is_ok());
+        CHECK(counter.arrays == 200000);
+    }
+}
+
+TEST_CASE("Writing") {
+    SUBCASE("Compact output round-trips") {
+        std::string json_str =
+            R"({"name":"brace","tags":["json","arena"],"nested":{"ok":true,)"
+            R"("none":null,"empty":{},"list":[]},"count":3,"ratio":0.1})";
+        CHECK(parse_json(json_str).to_string() == json_str);
+    }
+
+    SUBCASE("Pretty output is indented") {
+        auto value = parse_json(R"({"a": [1, 2], "b": {}})");
+        CHECK(
+            value.to_string(2)
+            == "{\n  \"a\": [\n    1,\n    2\n  ],\n  \"b\": {}\n}"
+        );
+    }
+
+    SUBCASE("Strings are escaped") {
+        JsonValue value(std::string("quote \" backslash \\ \n\t\x01 caf\xc3\xa9 /"));
+        CHECK(
+            value.to_string()
+            == R"("quote \" backslash \\ \n\t\u0001 caf)" "\xc3\xa9" R"( /")"
+        );
+        CHECK(parse_json("[" + value.to_string() + "]").to_array()[0] == std::string(value));
+    }
+
+    SUBCASE("Numbers keep their representation") {
+        auto value = parse_json(
+            "[0, -42, 18446744073709551615, 1.5, 3.0, 1e300, 0.1, -2.5e-8]"
+        );
+        CHECK(
+            value.to_string()
+            == "[0,-42,18446744073709551615,1.5,3.0,1e+300,0.1,-2.5e-08]"
+        );
+        auto reparsed = parse_json(value.to_string()).to_array();
+        CHECK(reparsed[4].type() == JsonType::Double);
+        CHECK(reparsed[6] == 0.1);
+    }
+
+    SUBCASE("Writers can stream into a sink") {
+        std::string streamed;
+        size_t chunks = 0;
+        Writer writer([&](std::string_view chunk) {
+            streamed.append(chunk);
+            chunks++;
+        });
+
+        JsonArray array;
+        for (int i = 0; i < 20000; i++) {
+            array.emplace_back(std::string("element ") + std::to_string(i));
+        }
+        JsonValue value(std::move(array));
+        writer.write(value);
+        CHECK(chunks > 1);
+        CHECK(writer.output().empty());
+        CHECK(streamed == value.to_string());
+    }
+}
+
+TEST_CASE("Event parsing") {
+    std::string json_str =
+        R"([{"id": 1, "price": 2.5, "tags": ["a"]}, {"id": 2, "price": 4}])";
+
+    SUBCASE("Events arrive in document order") {
+        struct Recorder: SaxHandler<Recorder> {
+            std::string events;
+
+            bool on_key(std::string_view key) {
+                events += std::string(key) + ":";
+                return true;
+            }
+
+            bool on_int64(int64_t) {
+                events += "i ";
+                return true;
+            }
+
+            bool on_uint64(uint64_t) {
+                events += "u ";
+                return true;
+            }
+
+            bool on_double(double) {
+                events += "d ";
+                return true;
+            }
+
+            bool on_string(std::string_view s) {
+                events += "'" + std::string(s) + "' ";
+                return true;
+            }
+
+            bool on_start_object() {
+                events += "{ ";
+                return true;
+            }
+
+            bool on_end_object(size_t members) {
+                events += std::to_string(members) + "} ";
+                return true;
+            }
+
+            bool on_start_array() {
+                events += "[ ";
+                return true;
+            }
+
+            bool on_end_array(size_t elements) {
+                events += std::to_string(elements) + "] ";
+                return true;
+            }
+        } recorder;
+
+        Parser parser;
+        CHECK(parser.parse_sax(json_str, recorder).is_ok());
+        CHECK(
+            recorder.events
+            == "[ { id:u price:d tags:[ 'a' 1] 3} { id:u price:u 2} 2] "
+        );
+    }
+
+    SUBCASE("Numbers default to on_number") {
+        struct Summer: SaxHandler<Summer> {
+            double sum = 0;
+
+            bool on_number(double n) {
+                sum += n;
+                return true;
+            }
+        } summer;
+
+        Parser parser;
+        CHECK(parser.parse_sax(json_str, summer).is_ok());
+        CHECK(summer.sum == 9.5);
+    }
+
+    SUBCASE("Handlers can stop parsing") {
+        struct FirstId: SaxHandler<FirstId> {
+            uint64_t id = 0;
+
+            bool on_uint64(uint64_t n) {
+                id = n;
+                return false;
+            }
+        } first;
+
+        Parser parser;
+        CHECK(parser.parse_sax(json_str, first).is_err());
+        CHECK(first.id == 1);
+    }
+
+    SUBCASE("Malformed input is reported") {
+        struct Ignore: SaxHandler<Ignore> {} ignore;
+        Parser parser;
+        CHECK(parser.parse_sax("[1, 2", ignore).is_err());
+        CHECK(parser.parse_sax(R"({"a" 1})", ignore).is_err());
+    }
+}
+
+TEST_CASE("On-demand parsing") {
+    std::string json_str = R"({
+        "skipped": {"deep": [[1, 2], {"x": "}"}], "more": [3]},
+        "id": 18446744073709551615,
+        "name": "caf\u00e9",
+        "tags": ["a", "b", "c"],
+        "ok": true,
+        "nothing": null,
+        "ratio": 0.25
+    })";
+    Parser parser;
+
+    SUBCASE("Values are read when accessed") {
+        auto document = parser.parse_lazy(json_str).unwrap_ok();
+        LazyValue root = document.root();
+        CHECK(root.is_object());
+        CHECK(root.size() == 7);
+        CHECK(root["id"].to_uint64() == UINT64_MAX);
+        CHECK(std::string(root["name"]) == "caf\xc3\xa9");
+        CHECK(root["tags"].size() == 3);
+        CHECK(std::string(root["tags"][2]) == "c");
+        CHECK(static_cast<bool>(root["ok"]));
+        CHECK(root["nothing"].is_null());
+        CHECK(static_cast<double>(root["ratio"]) == 0.25);
+        CHECK(root["ratio"].type() == JsonType::Double);
+        CHECK(root.contains("skipped"));
+        CHECK_FALSE(root.contains("missing"));
+        CHECK_THROWS(root["missing"]);
+        CHECK_THROWS(root["tags"][3]);
+    }
+
+    SUBCASE("Subtrees can be materialized") {
+        auto document = parser.parse_lazy(json_str).unwrap_ok();
+        auto skipped = document.root()["skipped"].get().unwrap_ok();
+        CHECK(skipped["deep"].to_array()[1]["x"] == "}");
+        CHECK(skipped["more"].to_array()[0] == 3);
+    }
+
+    SUBCASE("Comments fall back to scanning tokens") {
+        std::string commented = "// header\n[1, /* two */ 2, 3]";
+        auto document = parser.parse_lazy(commented).unwrap_ok();
+        CHECK(document.root().size() == 3);
+        CHECK(static_cast<int>(document.root()[1]) == 2);
+    }
+
+    SUBCASE("Trailing commas are accepted like in parse()") {
+        std::string trailing = R"({"a": [1, 2,], "b": {"c": null,},})";
+        auto document = parser.parse_lazy(trailing).unwrap_ok();
+        LazyValue root = document.root();
+        CHECK(root.size() == 2);
+        CHECK(root["a"].size() == 2);
+        CHECK(static_cast<int>(root["a"][1]) == 2);
+        CHECK(root["b"]["c"].is_null());
+        CHECK(root.get().unwrap_ok().to_string()
+              == parser.parse(trailing).unwrap_ok().to_string());
+        CHECK(parser.parse_lazy("[1, 2,]").unwrap_ok().root().size() == 2);
+        CHECK(parser.parse_lazy("[,]").is_err());
+        CHECK(parser.parse_lazy("{,}").is_err());
+    }
+
+    SUBCASE("Malformed structure is reported up front") {
+        for (std::string input :
+             {R"({"a" 1})", "[1 2]", "[1, 2", R"({"a": 1])", "[;]", ""}) {
+            CHECK(parser.parse_lazy(input).is_err());
+        }
+    }
+
+    SUBCASE("Malformed values are reported when read") {
+        std::string malformed = R"([1, tru, 1.5x, "\q"])";
+        auto document = parser.parse_lazy(malformed).unwrap_ok();
+        LazyValue root = document.root();
+        CHECK(root[1].get().is_err());
+        CHECK(root[2].get().is_err());
+        CHECK(root[3].get().is_err());
+        CHECK(static_cast<int>(root[size_t(0)]) == 1);
+        CHECK(root.get().is_err());
+    }
+}
+
+TEST_CASE("Chunked parsing") {
+    std::string json_str = R"({
+        "name": "caf\u00e9 \ud83d\ude00", // comment
+        "numbers": [0, -12, 3.5e-2, 18446744073709551615, true, false],
+        /* a longer
+           comment */ "nested": {"empty": {}, "list": [[], [null]]}
+    })";
+    Parser parser;
+    std::string expected = parser.parse(json_str).unwrap_ok().to_string();
+
+    SUBCASE("Values do not depend on where the input is split") {
+        StreamParser stream;
+        for (size_t chunk = 1; chunk <= json_str.size(); chunk++) {
+            for (size_t i = 0; i < json_str.size(); i += chunk) {
+                auto part = std::string_view(json_str).substr(i, chunk);
+                REQUIRE(stream.feed(part).is_ok());
+            }
+            auto value = stream.finish();
+            REQUIRE(value.is_ok());
+            CHECK(value.unwrap_ok().to_string() == expected);
+        }
+    }
+
+    SUBCASE("Trailing commas are accepted like in parse()") {
+        for (std::string input : {"[1, 2,]", R"({"a": 1,})", R"({"a": [[],], "b": {},})"}) {
+            std::string parsed = parser.parse(input).unwrap_ok().to_string();
+            for (size_t chunk = 1; chunk <= input.size(); chunk++) {
+                StreamParser stream;
+                for (size_t i = 0; i < input.size(); i += chunk) {
+                    REQUIRE(stream.feed(input.substr(i, chunk)).is_ok());
+                }
+                auto value = stream.finish();
+                REQUIRE(value.is_ok());
+                CHECK(value.unwrap_ok().to_string() == parsed);
+            }
+        }
+        StreamParser stream;
+        CHECK(stream.feed("[,]").is_err());
+    }
+
+    SUBCASE("Long strings across many chunks") {
+        std::string text(100000, 'x');
+        std::string long_str = "[\"" + text + "\", 1]";
+        StreamParser stream;
+        for (size_t i = 0; i < long_str.size(); i += 1000) {
+            REQUIRE(stream.feed(long_str.substr(i, 1000)).is_ok());
+        }
+        auto value = stream.finish().unwrap_ok();
+        CHECK(value.to_array()[0] == text.c_str());
+    }
+
+    SUBCASE("Long strings with escaped quotes across many chunks") {
+        // Rescanning the string from its start on every chunk would take
+        // far too long here
+        std::string text;
+        for (int i = 0; i < 200000; i++) {
+            text += "\\\"a\\\\";
+        }
+        std::string long_str = "[\"" + text + "\", 1]";
+        std::string expected =
+            parser.parse(long_str).unwrap_ok().to_array()[0].to_string();
+        StreamParser stream;
+        for (size_t i = 0; i < long_str.size(); i += 7) {
+            REQUIRE(stream.feed(long_str.substr(i, 7)).is_ok());
+        }
+        auto value = stream.finish().unwrap_ok();
+        CHECK(value.to_array()[0].to_string() == expected);
+        CHECK(value.to_array()[1] == 1);
+    }
+
+    SUBCASE("Malformed input is reported") {
+        StreamParser stream;
+        CHECK(stream.feed("[1, 2").is_ok());
+        CHECK(stream.feed("} ").is_err());
+        CHECK(stream.feed("]").is_err());
+        CHECK(stream.finish().is_err());
+
+        stream.reset();
+        CHECK(stream.feed("[1, tru").is_ok());
+        // Reported once it can not be the start of a longer token
+        auto result = stream.feed("x]");
+        CHECK((result.is_err() || stream.finish().is_err()));
+
+        for (std::string input : {"", "[1, 2", R"({"a": )", R"("abc)", "nul"}) {
+            stream.reset();
+            CHECK(stream.feed(input).is_ok());
+            CHECK(stream.finish().is_err());
+        }
+    }
+
+    SUBCASE("Parsers are reused after finishing") {
+        StreamParser stream;
+        CHECK(stream.feed("[1]").is_ok());
+        CHECK(stream.finish().unwrap_ok().to_array().size() == 1);
+        CHECK(stream.feed("12").is_ok());
+        CHECK(stream.feed("34 ").is_ok());
+        CHECK(stream.finish().unwrap_ok() == 1234);
+    }
+}
+
+TEST_CASE("Newline-delimited records") {
+    std::string input;
+    for (int i = 0; i < 20000; i++) {
+        input += R"({"id": )" + std::to_string(i)
+            + R"(, "message": "something happened", "tags": ["a", "b"]})";
+        input += i % 1000 == 999 ? "\r\n\n" : "\n";
+    }
+    Parser parser;
+
+    for (size_t threads : {1, 4}) {
+        std::vector<size_t> lines;
+        int64_t expected_id = 0;
+        bool in_order = true;
+        size_t count = parser.parse_many(
+            input,
+            [&](size_t line, Result<JsonValue, ParseError>&& record) {
+                JsonValue value = std::move(record).unwrap_ok();
+                in_order = in_order && value["id"] == expected_id++;
+                lines.push_back(line);
+                return true;
+            },
+            threads
+        );
+        CHECK(count == 20000);
+        CHECK(in_order);
+        CHECK(lines[999] == 1000);
+        CHECK(lines[1000] == 1002);  // After a blank line
+        CHECK(lines.back() == 20000 + 19);
+    }
+
+    SUBCASE("Malformed records are passed on") {
+        size_t position = input.find("\n", input.size() / 2) + 1;
+        input.insert(position, "{oops}\n");
+        size_t expected_line =
+            std::count(input.begin(), input.begin() + position, '\n') + 1;
+        size_t errors = 0;
+        size_t error_line = 0;
+        size_t count = parser.parse_many(
+            input,
+            [&](size_t line, Result<JsonValue, ParseError>&& record) {
+                if (record.is_err()) {
+                    errors++;
+                    error_line = line;
+                }
+                return true;
+            },
+            3
+        );
+        CHECK(count == 20001);
+        CHECK(errors == 1);
+        CHECK(error_line == expected_line);
+    }
+
+    SUBCASE("Handlers stop early") {
+        size_t count = parser.parse_many(
+            input,
+            [](size_t, Result<JsonValue, ParseError>&&) { return false; },
+            4
+        );
+        CHECK(count == 1);
+    }
+}
+
+TEST_CASE("Parallel parsing") {
+    std::string json_str = "[\n";
+    for (int i = 0; i < 20000; i++) {
+        json_str += R"(  {"id": )" + std::to_string(i)
+            + R"(, "text": "a, [tricky] {string}", "list": [1, [2, 3]]})";
+        json_str += i < 19999 ? ",\n" : "\n";
+    }
+    json_str += "]\n";
+    Parser parser;
+    std::string expected = parser.parse(json_str).unwrap_ok().to_string();
+
+    SUBCASE("Results match sequential parsing") {
+        auto value = parser.parse_parallel(json_str, 4).unwrap_ok();
+        CHECK(value.to_array().size() == 20000);
+        CHECK(value.to_string() == expected);
+    }
+
+    SUBCASE("Malformed elements are reported") {
+        std::string malformed = json_str;
+        malformed.insert(malformed.size() / 2, "@");
+        CHECK(parser.parse_parallel(malformed, 4).is_err());
+
+        std::string unbalanced = json_str.substr(0, json_str.size() - 2) + "}";
+        CHECK(parser.parse_parallel(unbalanced, 4).is_err());
+    }
+
+    SUBCASE("Trailing commas are accepted like in parse()") {
+        std::string trailing = json_str;
+        trailing.insert(trailing.rfind('}') + 1, ",");
+        auto value = parser.parse_parallel(trailing, 4).unwrap_ok();
+        CHECK(value.to_string() == expected);
+
+        // Where the last range may begin
+        std::string split = "[";
+        while (split.size() < 2 * 1024 * 1024) {
+            split += "1,";
+        }
+        split += "]";
+        for (size_t threads = 2; threads <= 8; threads++) {
+            auto result = parser.parse_parallel(split, threads);
+            REQUIRE(result.is_ok());
+            CHECK(result.unwrap_ok().to_array().size() == (split.size() - 2) / 2);
+        }
+    }
+
+    SUBCASE("Other inputs are parsed sequentially") {
+        std::string commented = json_str;
+        commented.insert(commented.find("\n", commented.size() / 2), "// .");
+        auto value = parser.parse_parallel(commented, 4).unwrap_ok();
+        CHECK(value.to_array().size() == 20000);
+
+        std::string object = "{\"records\": " + json_str + "}";
+        value = parser.parse_parallel(object, 4).unwrap_ok();
+        CHECK(value["records"].to_array().size() == 20000);
+    }
+}
+
+TEST_CASE("Files") {
+    TempFile file;
+    const std::string& path = file.path();
+    Parser parser;
+
+    SUBCASE("Files are parsed in place") {
+        std::string json_str = R"({"name": "brace", "list": [1, 2, 3]})";
+        std::ofstream(path, std::ios::binary) << json_str;
+        auto value = parser.parse_file(path).unwrap_ok();
+        CHECK(value["name"] == "brace");
+        CHECK(value.to_string() == parser.parse(json_str).unwrap_ok().to_string());
+    }
+
+    SUBCASE("Empty and missing files are errors") {
+        std::ofstream(path, std::ios::binary).close();
+        CHECK(parser.parse_file(path).is_err());
+        std::remove(path.c_str());
+        CHECK(parser.parse_file(path).is_err());
+    }
+}
+
+TEST_CASE("String views and padded input") {
+    Parser parser;
+
+    SUBCASE("Views into larger buffers") {
+        std::string buffer = R"(garbage[1, "two", {"three": 3}]garbage)";
+        auto view = std::string_view(buffer).substr(7, 24);
+        CHECK(parser.parse(view).unwrap_ok().to_array().size() == 3);
+        CHECK(parser.parse(buffer.data() + 7, 24).is_ok());
+        CHECK(parser.parse(buffer.data() + 7, 23).is_err());
+        CHECK(parser.parse_document(view).is_ok());
+    }
+
+    SUBCASE("Padding is never parsed") {
+        // Padding that would be tokens, comments and unterminated strings
+        std::string padding;
+        while (padding.size() < input_padding) {
+            padding += "\"/*{[1,";
+        }
+
+        for (size_t length = 0; length < 400; length += 7) {
+            std::string json_str =
+                R"([{"key": ")" + std::string(length, 'x') + R"("}, "end", 12])";
+            std::string buffer = json_str + padding;
+            PaddedInput input(buffer.data(), json_str.size());
+
+            auto value = parser.parse(input);
+            REQUIRE(value.is_ok());
+            CHECK(value.unwrap_ok().to_array()[2] == 12);
+            CHECK(parser.parse_document(input).is_ok());
+
+            struct Count: SaxHandler<Count> {
+                size_t strings = 0;
+                bool on_string(std::string_view) {
+                    strings++;
+                    return true;
+                }
+            } count;
+            REQUIRE(parser.parse_sax(input, count).is_ok());
+            CHECK(count.strings == 2);
+
+            std::string unterminated = json_str.substr(0, json_str.size() - 5);
+            buffer = unterminated + padding;
+            CHECK(parser.parse(PaddedInput(buffer.data(), unterminated.size()))
+                      .is_err());
+        }
+    }
+}
+
+struct Address {
+    std::string city;
+    std::optional<std::string> street;
+};
+BRACE_FIELDS(Address, city, street)
+
+struct Account {
+    uint32_t id = 0;
+    std::string name;
+    bool active = false;
+    double balance = 0;
+    int8_t level = 0;
+    std::vector<Address> addresses;
+    std::vector<bool> flags;
+    std::optional<int64_t> parent;
+    JsonValue extra;
+};
+BRACE_FIELDS(Account, id, name, active, balance, level, addresses, flags, parent, extra)
+
+TEST_CASE("Parsing into structs") {
+    Parser parser;
+    std::string json_str = R"({
+        "id": 42,
+        "name": "J\u00f6rg",
+        "unknown": {"nested": [1, {"deeper": null}], "s": "}"},
+        "active": true,
+        "balance": -12.5,
+        "level": -3,
+        "addresses": [{"city": "Oslo"}, {"city": "Bergen", "street": "Bryggen"}],
+        "flags": [true, false, true],
+        "parent": null,
+        "extra": {"anything": [1, "two"]}
+    })";
+
+    SUBCASE("Members are read by key") {
+        Account account;
+        account.parent = 7;
+        REQUIRE(parser.parse_into(json_str, account).is_ok());
+        CHECK(account.id == 42);
+        CHECK(account.name == "J\xc3\xb6rg");
+        CHECK(account.active);
+        CHECK(account.balance == -12.5);
+        CHECK(account.level == -3);
+        REQUIRE(account.addresses.size() == 2);
+        CHECK(account.addresses[0].city == "Oslo");
+        CHECK(!account.addresses[0].street);
+        CHECK(account.addresses[1].street == "Bryggen");
+        CHECK(account.flags == std::vector<bool> {true, false, true});
+        CHECK(!account.parent);
+        CHECK(account.extra["anything"][1] == "two");
+    }
+
+    SUBCASE("Missing members keep their value") {
+        Account account;
+        account.name = "unchanged";
+        REQUIRE(parser.parse_into(R"({"id": 1, "parent": 9})", account).is_ok());
+        CHECK(account.id == 1);
+        CHECK(account.name == "unchanged");
+        CHECK(account.parent == 9);
+
+        std::vector<Address> addresses;
+        REQUIRE(parser.parse_into("[]", addresses).is_ok());
+        CHECK(addresses.empty());
+    }
+
+    SUBCASE("Mismatched input") {
+        Account account;
+        CHECK(parser.parse_into(R"({"id": "42"})", account).is_err());
+        CHECK(parser.parse_into(R"({"id": -1})", account).is_err());
+        CHECK(parser.parse_into(R"({"id": 1.5})", account).is_err());
+        CHECK(parser.parse_into(R"({"id": 4294967296})", account).is_err());
+        CHECK(parser.parse_into(R"({"level": 128})", account).is_err());
+        CHECK(parser.parse_into(R"({"active": null})", account).is_err());
+        CHECK(parser.parse_into(R"({"addresses": {}})", account).is_err());
+        CHECK(parser.parse_into(R"({"extra": [1, }})", account).is_err());
+        CHECK(parser.parse_into(R"({"unknown": [})", account).is_err());
+        CHECK(parser.parse_into(R"({"id": 1} ")", account).is_err());
+        CHECK(parser.parse_into("[]", account).is_err());
+        CHECK(parser.parse_into("", account).is_err());
+
+        // The parser is still usable afterwards
+        CHECK(parser.parse_into(json_str, account).is_ok());
+        CHECK(parser.parse(json_str).is_ok());
+    }
+}
+
+TEST_CASE("Paths") {
+    Parser parser;
+    std::string json_str = R"({
+        "data": {
+            "items": [{"id": 1}, {"id": 2}, {"id": 3}, {"id": 4, "tags": ["x"]}],
+            "a/b": {"m~n": true},
+            "7": "seven"
+        },
+        "total": 4
+    })";
+    auto compile = [](std::string_view pointer) {
+        return Path::compile(pointer).unwrap_ok();
+    };
+
+    SUBCASE("Pointers are compiled") {
+        CHECK(compile("").size() == 0);
+        Path path = compile("/data/a~1b/m~0n/");
+        REQUIRE(path.size() == 4);
+        CHECK(path.steps()[1].key == "a/b");
+        CHECK(path.steps()[2].key == "m~n");
+        CHECK(path.steps()[3].key.empty());
+        CHECK(compile("/12").steps()[0].index == 12);
+        CHECK(compile("/012").steps()[0].index == Path::npos);
+        CHECK(compile("/-").steps()[0].index == Path::npos);
+
+        CHECK(Path::compile("data").is_err());
+        CHECK(Path::compile("/a~2").is_err());
+        CHECK(Path::compile("/a~").is_err());
+    }
+
+    SUBCASE("Paths are looked up in values") {
+        JsonValue root = parser.parse(json_str).unwrap_ok();
+        CHECK(root.find(compile("")) == &root);
+        CHECK(*root.find(compile("/data/items/3/id")) == 4);
+        CHECK(root.find(compile("/data/a~1b/m~0n"))->is_bool());
+        CHECK(*root.find(compile("/data/7")) == "seven");
+        CHECK(root.find(compile("/data/items/4")) == nullptr);
+        CHECK(root.find(compile("/data/items/id")) == nullptr);
+        CHECK(root.find(compile("/total/0")) == nullptr);
+        CHECK(root.find(compile("/missing")) == nullptr);
+
+        // Large objects are looked up through their hash index
+        JsonObject large;
+        for (int i = 0; i < 100; i++) {
+            large.insert_or_assign(JsonString("key" + std::to_string(i)), JsonValue(i));
+        }
+        JsonValue value(std::move(large));
+        CHECK(*value.find(compile("/key77")) == 77);
+        CHECK(value.find(compile("/key100")) == nullptr);
+
+        auto document = parser.parse_lazy(json_str).unwrap_ok();
+        auto cursor = document.root().find(compile("/data/items/3/tags/0"));
+        REQUIRE(cursor);
+        CHECK(std::string(*cursor) == "x");
+        CHECK(!document.root().find(compile("/data/items/9")));
+        CHECK(!document.root().find(compile("/total/x")));
+    }
+
+    SUBCASE("Paths are extracted while parsing") {
+        std::vector<Path> paths = {
+            compile("/data/items/1/id"),
+            compile("/total"),
+            compile("/data/items/3"),
+            compile("/data/items/3/tags/0"),
+            compile("/data/missing"),
+            compile("/total"),
+        };
+        std::vector<std::optional<JsonValue>> values;
+        CHECK(parser.parse_paths(json_str, paths, values).unwrap_ok() == 5);
+        REQUIRE(values.size() == 6);
+        CHECK(*values[0] == 2);
+        CHECK(*values[1] == 4);
+        CHECK((*values[2])["id"] == 4);
+        CHECK(*values[3] == "x");
+        CHECK(!values[4]);
+        CHECK(*values[5] == 4);
+
+        std::vector<Path> root = {compile("")};
+        CHECK(parser.parse_paths("[1, [2]]", root, values).unwrap_ok() == 1);
+        CHECK((*values[0])[size_t(1)][size_t(0)] == 2);
+    }
+
+    SUBCASE("Scanning stops once every path is resolved") {
+        std::vector<Path> paths = {compile("/head/id"), compile("/head/x/y")};
+        std::vector<std::optional<JsonValue>> values;
+        std::string truncated = R"({"head": {"id": 7, "x": 1}, "body": [1, 2, {)";
+        CHECK(parser.parse_paths(truncated, paths, values).unwrap_ok() == 1);
+        CHECK(*values[0] == 7);
+        CHECK(!values[1]);
+
+        CHECK(parser.parse_paths(R"({"head": [})", paths, values).is_err());
+        CHECK(parser.parse_paths(R"({"body": 1} 2 ")", paths, values).is_ok());
+    }
+}
+
+TEST_CASE("Parse stats") {
+    Parser parser;
+    std::string json_str = R"({"name": "longer than any inline string",)"
+                           R"( "list": [1, 2.5, [true, null]]})";
+    parser.parse(json_str).unwrap_ok();
+    const ParseStats& stats = parser.stats();
+
+    if (!ParseStats::enabled) {
+        CHECK(stats.bytes_scanned == 0);
+        CHECK(stats.tokens() == 0);
+        CHECK(stats.allocations == 0);
+        return;
+    }
+
+    SUBCASE("Tokens, depth and allocations are counted") {
+        CHECK(stats.bytes_scanned == json_str.size());
+        CHECK(stats.strings == 3);
+        CHECK(stats.numbers == 2);
+        CHECK(stats.keywords == 2);
+        CHECK(stats.braces == 2);
+        CHECK(stats.brackets == 4);
+        CHECK(stats.colons == 2);
+        CHECK(stats.commas == 4);
+        CHECK(stats.tokens() == 19);
+        CHECK(stats.max_depth == 3);
+        CHECK(stats.allocations > 0);
+        CHECK(stats.allocated_bytes > stats.allocations);
+
+        parser.parse("1").unwrap_ok();
+        CHECK(stats.tokens() == 1);
+        CHECK(stats.max_depth == 0);
+        CHECK(stats.allocations == 0);
+
+        CHECK(parser.parse("[1, @]").is_err());
+        CHECK(stats.numbers == 1);
+    }
+
+    SUBCASE("Records add up") {
+        std::string ndjson = "{\"a\": 1}\n{\"a\": 2}\n\n{\"a\": [3]}\n";
+        parser.parse_many(ndjson, [](size_t, auto&&) { return true; });
+        CHECK(stats.numbers == 3);
+        CHECK(stats.strings == 3);
+        CHECK(stats.max_depth == 2);
+    }
+
+    SUBCASE("Threads add up") {
+        std::string array = "[\n";
+        for (int i = 0; i < 50000; i++) {
+            array += R"(  {"id": )" + std::to_string(i);
+            array += R"(, "list": [1, [2]]},)" "\n";
+        }
+        array += "  0\n]\n";
+        parser.parse(array).unwrap_ok();
+        ParseStats sequential = stats;
+        parser.parse_parallel(array, 4).unwrap_ok();
+        CHECK(stats.tokens() == sequential.tokens());
+        CHECK(stats.numbers == sequential.numbers);
+        CHECK(stats.brackets == sequential.brackets);
+        CHECK(stats.max_depth == sequential.max_depth);
+    }
+}
+
+TEST_CASE("Shared values") {
+    std::string json_str = R"({"name": "a name too long to be inline",)"
+                           R"( "list": [1, 2, {"a": true}]})";
+    Parser parser;
+    parser.set_shared_values(true);
+    JsonValue value = parser.parse(json_str).unwrap_ok();
+
+    SUBCASE("Copies share their contents") {
+        CHECK(value.is_shared());
+        CHECK(value["name"].is_shared());
+        CHECK_FALSE(value["list"][size_t(0)].is_shared());
+
+        JsonValue copy = value;
+        CHECK(&copy.to_object() == &value.to_object());
+        CHECK(copy.to_string() == value.to_string());
+
+        JsonValue root = parser.parse(json_str).unwrap_ok();
+        JsonValue list = root["list"];
+        root = JsonValue();
+        CHECK(list.to_array().size() == 3);
+        CHECK(bool(list[size_t(2)]["a"]));
+    }
+
+    SUBCASE("Unshared values are shared by copying them once") {
+        JsonValue unshared = parse_json(json_str);
+        CHECK_FALSE(unshared.is_shared());
+        JsonValue shared = unshared.share();
+        CHECK(shared.is_shared());
+        CHECK(shared["list"].is_shared());
+        CHECK(shared.to_string() == unshared.to_string());
+        CHECK(&shared.share().to_object() == &shared.to_object());
+    }
+
+    SUBCASE("Changes copy only the path to them") {
+        auto path = Path::compile("/list/2/a").unwrap_ok();
+        JsonValue changed = value.with(path, JsonValue(false)).value();
+        CHECK_FALSE(bool(changed["list"][size_t(2)]["a"]));
+        CHECK(bool(value["list"][size_t(2)]["a"]));
+        CHECK(changed.is_shared());
+        CHECK(changed["list"].is_shared());
+        CHECK(&changed["name"].to_string_view()[0]
+              == &value["name"].to_string_view()[0]);
+
+        auto added = Path::compile("/list/-").unwrap_ok();
+        JsonValue appended = value.with(added, JsonValue(4)).value();
+        CHECK(appended["list"].to_array().size() == 4);
+        auto member = Path::compile("/extra").unwrap_ok();
+        CHECK(value.with(member, JsonValue(1)).value()["extra"] == 1);
+        auto nowhere = Path::compile("/name/x").unwrap_ok();
+        CHECK_FALSE(value.with(nowhere, JsonValue()).has_value());
+        auto missing = Path::compile("/missing/x").unwrap_ok();
+        CHECK_FALSE(value.with(missing, JsonValue()).has_value());
+
+        JsonValue unshared = parse_json(json_str);
+        JsonValue root = unshared.with(Path(), JsonValue(1)).value();
+        CHECK(root == 1);
+        CHECK_FALSE(unshared.with(path, JsonValue(false)).value().is_shared());
+    }
+
+    SUBCASE("Copies are handed to other threads") {
+        std::vector<std::thread> threads;
+        std::atomic<size_t> names {0};
+        for (int i = 0; i < 4; i++) {
+            threads.emplace_back([&, copy = value] {
+                for (int n = 0; n < 1000; n++) {
+                    JsonValue again = copy;
+                    names += again["name"].to_string_view().size();
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        CHECK(names == 4 * 1000 * 28);
+    }
+
+    SUBCASE("Equal strings can be stored once") {
+        parser.set_intern_strings(true);
+        std::string records = R"({"user": "somebody@example.com"})" "\n"
+                              R"({"user": "somebody@example.com"})" "\n";
+        std::vector<JsonValue> users;
+        size_t parsed = parser.parse_many(
+            records,
+            [&](size_t, Result<JsonValue, ParseError>&& record) {
+                users.push_back(std::move(record).unwrap_ok()["user"]);
+                return true;
+            },
+            1
+        );
+        REQUIRE(parsed == 2);
+        CHECK(users[0].is_shared());
+        CHECK(users[0].to_string_view().data() == users[1].to_string_view().data());
+
+        JsonValue list = parser.parse(R"(["a value to dedupe", "a value to dedupe"])")
+                             .unwrap_ok();
+        CHECK(list[size_t(0)].to_string_view().data()
+              == list[size_t(1)].to_string_view().data());
+        CHECK(list[size_t(0)].to_string_view().data()
+              != users[0].to_string_view().data());
+        list = JsonValue();
+        CHECK(users[1] == "somebody@example.com");
+    }
+}
+
+TEST_CASE("Snapshots") {
+    std::string json_str = R"({"id": 18446744073709551615, "name": "caf\u00e9",)"
+                           R"( "tags": ["a", "b", "a"], "ok": true, "nothing": null,)"
+                           R"( "ratio": 0.25, "offset": -7, "empty": {}})";
+    JsonValue value = parse_json(json_str);
+
+    SUBCASE("Values are read in place") {
+        std::string bytes = Snapshot::encode(value).unwrap_ok();
+        auto snapshot = Snapshot::view(bytes).unwrap_ok();
+        SnapshotValue root = snapshot.root();
+        CHECK(root.is_object());
+        CHECK(root.size() == 8);
+        CHECK(root["id"].to_uint64() == UINT64_MAX);
+        CHECK(root["name"].to_string_view() == "caf\xc3\xa9");
+        CHECK(root["name"].to_string_view().data() >= bytes.data());
+        CHECK(root["tags"].size() == 3);
+        CHECK(std::string(root["tags"][2]) == "a");
+        CHECK(static_cast<bool>(root["ok"]));
+        CHECK(root["nothing"].is_null());
+        CHECK(static_cast<double>(root["ratio"]) == 0.25);
+        CHECK(root["offset"].to_int64() == -7);
+        CHECK(root["empty"].size() == 0);
+        CHECK_FALSE(root.contains("missing"));
+        CHECK_THROWS(root["missing"]);
+        CHECK_THROWS(root["tags"][3]);
+        CHECK(root.get().to_string() == value.to_string());
+
+        auto path = Path::compile("/tags/1").unwrap_ok();
+        CHECK(std::string(root.find(path).value()) == "b");
+        CHECK_FALSE(root.find(Path::compile("/tags/9").unwrap_ok()).has_value());
+    }
+
+    SUBCASE("Small integers are stored in place") {
+        JsonValue numbers = parse_json(
+            "[0, -1, 1073741823, -1073741824, 1073741824, -1073741825,"
+            " -9223372036854775808, 1.5]"
+        );
+        std::string bytes = Snapshot::encode(numbers).unwrap_ok();
+        SnapshotValue root = Snapshot::view(bytes).unwrap_ok().root();
+        for (size_t i = 0; i < root.size(); i++) {
+            CHECK(root[i].type() == numbers[i].type());
+            CHECK(root[i].get() == numbers[i].to_double());
+        }
+        CHECK(root[size_t(3)].to_int64() == -1073741824);
+        CHECK(root[size_t(6)].to_int64() == INT64_MIN);
+        CHECK(root.get().to_string() == numbers.to_string());
+
+        std::string scalar = Snapshot::encode(JsonValue(-5)).unwrap_ok();
+        CHECK(Snapshot::view(scalar).unwrap_ok().root().to_int64() == -5);
+    }
+
+    SUBCASE("Large objects are searched by key") {
+        std::string large = "{";
+        for (int i = 99; i >= 0; i--) {
+            large += "\"key" + std::to_string(i) + "\": " + std::to_string(i)
+                + (i ? ", " : "}");
+        }
+        JsonValue object = parse_json(large);
+        std::string bytes = Snapshot::encode(object).unwrap_ok();
+        SnapshotValue root = Snapshot::view(bytes).unwrap_ok().root();
+        for (int i = 0; i < 100; i++) {
+            CHECK(static_cast<int>(root["key" + std::to_string(i)]) == i);
+        }
+        CHECK_FALSE(root.contains("key100"));
+        CHECK(root.get().to_string() == object.to_string());
+    }
+
+    SUBCASE("Snapshots are saved and mapped from files") {
+        TempFile file;
+        const std::string& path = file.path();
+        REQUIRE(Snapshot::write(value, path).is_ok());
+        auto snapshot = Snapshot::open(path).unwrap_ok();
+        SnapshotValue root = snapshot.root();
+        Snapshot moved = std::move(snapshot);
+        CHECK(root["tags"][size_t(0)].to_string_view() == "a");
+        CHECK(moved.root().get().to_string() == value.to_string());
+    }
+
+    SUBCASE("Concurrent writers each replace the whole snapshot") {
+        TempFile file;
+        std::vector<JsonValue> values;
+        for (int i = 0; i < 4; i++) {
+            JsonArray list;
+            list.resize(1000 * (i + 1), JsonValue(i));
+            values.emplace_back(std::move(list));
+        }
+        std::atomic<bool> written {true};
+        std::vector<std::thread> threads;
+        for (const JsonValue& each : values) {
+            threads.emplace_back([&, each = &each] {
+                for (int i = 0; i < 20; i++) {
+                    if (Snapshot::write(*each, file.path()).is_err()) {
+                        written = false;
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        CHECK(written);
+        auto snapshot = Snapshot::open(file.path()).unwrap_ok();
+        std::string saved = snapshot.root().get().to_string();
+        CHECK(std::any_of(values.begin(), values.end(), [&](const JsonValue& each) {
+            return each.to_string() == saved;
+        }));
+
+        size_t left = 0;
+        auto directory = std::filesystem::path(file.path()).parent_path();
+        auto name = std::filesystem::path(file.path()).filename().string();
+        for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+            left += entry.path().filename().string().rfind(name + ".", 0) == 0;
+        }
+        CHECK(left == 0);
+    }
+
+    SUBCASE("Damaged snapshots are read within their bytes") {
+        std::string bytes = Snapshot::encode(value).unwrap_ok();
+        uint64_t patterns[] = {UINT64_MAX, 0x7fffffff00000007, 0x0000000300000008, 0};
+        for (size_t at = 24; at < bytes.size(); at += 4) {
+            for (uint64_t pattern : patterns) {
+                std::string damaged = bytes;
+                std::memcpy(&damaged[at], &pattern, std::min<size_t>(8, damaged.size() - at));
+                SnapshotValue root = Snapshot::view(damaged).unwrap_ok().root();
+                (void)root.get().to_string();
+                if (root.is_object()) {
+                    (void)root.contains("tags");
+                    (void)root.contains("name");
+                }
+            }
+        }
+
+        // The root object's head, claiming more members than fit
+        std::string damaged = bytes;
+        uint64_t head = (uint64_t(1) << 40) << 8 | 8;
+        std::memcpy(&damaged[24], &head, sizeof(head));
+        SnapshotValue root = Snapshot::view(damaged).unwrap_ok().root();
+        CHECK(root.is_object());
+        CHECK(root.size() == 0);
+        CHECK_FALSE(root.contains("name"));
+    }
+
+    SUBCASE("Other bytes are rejected") {
+        std::string bytes = Snapshot::encode(value).unwrap_ok();
+        CHECK(Snapshot::view("").is_err());
+        CHECK(Snapshot::view(json_str).is_err());
+        auto truncated = Snapshot::view(std::string_view(bytes).substr(0, bytes.size() - 8));
+        REQUIRE(truncated.is_err());
+        CHECK(truncated.unwrap_err().code() == ErrorCode::InvalidSnapshot);
+        CHECK(Snapshot::open("/nonexistent/snapshot").is_err());
+    }
+}